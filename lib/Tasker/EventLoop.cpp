@@ -0,0 +1,193 @@
+#include "EventLoop.h"
+#include <algorithm>
+
+EventLoop::EventLoop(const Tasker &tasker, const char *name, TaskOptions options) :
+        tasker(tasker),
+        name(name),
+        options(options) {}
+
+EventLoop::TimerId EventLoop::after(uint32_t millis, std::function<void(void)> callback) {
+    return add(millis, 0, std::move(callback));
+}
+
+EventLoop::TimerId EventLoop::every(uint32_t millis, std::function<void(void)> callback) {
+    return add(millis, millis, std::move(callback));
+}
+
+void EventLoop::cancel(TimerId timer) {
+    std::lock_guard<std::mutex> lg(timersMutex);
+    timers.erase(timer); // entries in the wheel are skipped when their slot comes
+}
+
+EventBits_t EventLoop::onEvent(std::function<void(void)> handler) {
+    start();
+    std::lock_guard<std::mutex> lg(handlersMutex);
+    if (handlers.size() >= USER_BITS) {
+        return 0;
+    }
+    handlers.push_back(std::make_shared<std::function<void(void)>>(std::move(handler)));
+    return 1 << (handlers.size() - 1);
+}
+
+void EventLoop::signal(EventBits_t bits) {
+    xEventGroupSetBits(events, bits);
+}
+
+void EventLoop::signalFromISR(EventBits_t bits) {
+    BaseType_t woken = pdFALSE;
+    if (xEventGroupSetBitsFromISR(events, bits, &woken) == pdPASS && woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void EventLoop::start() {
+    std::call_once(started, [this] {
+        events = xEventGroupCreate();
+        current = nowTicks();
+        task = tasker.once(name, [this] { run(); }, options);
+    });
+}
+
+void EventLoop::run() {
+    const EventBits_t allBits = WAKE_BIT | ((1 << USER_BITS) - 1);
+    for (;;) {
+        TickType_t timeout;
+        {
+            std::lock_guard<std::mutex> lg(timersMutex);
+            uint32_t toSlot = ticksToNextSlot();
+            uint32_t now = nowTicks();
+            if (toSlot == UINT32_MAX) {
+                timeout = portMAX_DELAY;
+            } else {
+                uint32_t deadline = current + toSlot;
+                timeout = (int32_t) (deadline - now) <= 0 ? 0 : pdMS_TO_TICKS((deadline - now) * TICK_MS);
+            }
+        }
+
+        EventBits_t bits = xEventGroupWaitBits(events, allBits, pdTRUE, pdFALSE, timeout) & allBits & ~WAKE_BIT;
+        if (bits != 0) {
+            std::vector<Callback> signalled;
+            {
+                std::lock_guard<std::mutex> lg(handlersMutex);
+                for (size_t i = 0; i < handlers.size(); i++) {
+                    if (bits & (1 << i)) signalled.push_back(handlers[i]);
+                }
+            }
+            for (const auto &handler: signalled) {
+                (*handler)();
+            }
+        }
+
+        advance(nowTicks());
+    }
+}
+
+EventLoop::TimerId EventLoop::add(uint32_t millis, uint32_t period, std::function<void(void)> callback) {
+    start();
+    TimerId id;
+    {
+        std::lock_guard<std::mutex> lg(timersMutex);
+        id = nextId++;
+        uint32_t periodTicks = period == 0 ? 0 : std::max((period + TICK_MS - 1) / TICK_MS, (uint32_t) 1);
+        uint32_t expires = nowTicks() + std::max((millis + TICK_MS - 1) / TICK_MS, (uint32_t) 1);
+        timers[id] = {expires, periodTicks, std::make_shared<std::function<void(void)>>(std::move(callback))};
+        schedule(id, expires);
+    }
+    xEventGroupSetBits(events, WAKE_BIT);
+    return id;
+}
+
+void EventLoop::schedule(TimerId id, uint32_t expires) {
+    if ((int32_t) (expires - current) < 0) {
+        expires = current;
+    }
+    if (expires - current < SLOTS) {
+        wheel[0][expires % SLOTS].push_back(id);
+    } else if ((expires >> SLOT_BITS) - (current >> SLOT_BITS) < SLOTS) {
+        wheel[1][(expires >> SLOT_BITS) % SLOTS].push_back(id);
+    } else {
+        // too far timers wait in the last slot and are scheduled again when it cascades
+        uint32_t slot = std::min((expires >> 2 * SLOT_BITS) - (current >> 2 * SLOT_BITS), SLOTS - 1);
+        wheel[2][((current >> 2 * SLOT_BITS) + slot) % SLOTS].push_back(id);
+    }
+}
+
+void EventLoop::advance(uint32_t now) {
+    std::vector<Callback> due;
+    std::vector<TimerId> slot;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lg(timersMutex);
+            // ticks are processed under the lock until some callbacks are due
+            while (due.empty() && (int32_t) (now - current) >= 0) {
+                if (current % SLOTS == 0) {
+                    if (current % (SLOTS * SLOTS) == 0) cascade(2);
+                    cascade(1);
+                }
+                slot.swap(wheel[0][current % SLOTS]);
+                for (TimerId id: slot) {
+                    auto timer = timers.find(id);
+                    if (timer == timers.end()) continue; // cancelled
+                    if ((int32_t) (timer->second.expires - current) > 0) {
+                        schedule(id, timer->second.expires);
+                        continue;
+                    }
+                    due.push_back(timer->second.callback);
+                    if (timer->second.period == 0) {
+                        timers.erase(timer);
+                    } else {
+                        timer->second.expires = current + timer->second.period;
+                        schedule(id, timer->second.expires);
+                    }
+                }
+                slot.clear();
+                current++;
+            }
+        }
+        if (due.empty()) {
+            return;
+        }
+        for (const auto &callback: due) {
+            (*callback)();
+        }
+        due.clear();
+    }
+}
+
+void EventLoop::cascade(int level) {
+    std::vector<TimerId> slot;
+    slot.swap(wheel[level][(current >> level * SLOT_BITS) % SLOTS]);
+    for (TimerId id: slot) {
+        auto timer = timers.find(id);
+        if (timer != timers.end()) schedule(id, timer->second.expires);
+    }
+}
+
+uint32_t EventLoop::ticksToNextSlot() const {
+    uint32_t next = UINT32_MAX;
+    for (uint32_t k = 0; k < SLOTS; k++) {
+        if (!wheel[0][(current + k) % SLOTS].empty()) {
+            next = k;
+            break;
+        }
+    }
+    // an upper level timer may be due before the lowest one, the loop has to wake up for its cascade
+    for (int level = 1; level < LEVELS; level++) {
+        uint32_t shift = level * SLOT_BITS;
+        // the actual slot is non-empty only when its cascade is pending (at the very start of the slot)
+        for (uint32_t k = 0; k < SLOTS; k++) {
+            if (!wheel[level][((current >> shift) + k) % SLOTS].empty()) {
+                uint32_t start = ((current >> shift) + k) << shift;
+                next = std::min(next, start > current ? start - current : 0);
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+uint32_t EventLoop::nowTicks() {
+    return (uint32_t) (esp_timer_get_time() / 1000 / TICK_MS);
+}
+
+EventLoop DefaultEventLoop(DefaultTasker, "events");
@@ -0,0 +1,124 @@
+#ifndef SOUNDBOX_EVENTLOOP_H
+#define SOUNDBOX_EVENTLOOP_H
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <freertos/event_groups.h>
+#endif
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Tasker.h"
+
+/**
+ * Cooperative scheduler of timers and events sharing a single task.
+ *
+ * Timers are kept in a hierarchical timer wheel (3 levels of 64 slots, tick `TICK_MS`), so adding, cancelling and
+ * firing a timer costs the same regardless of how many timers there are. Between deadlines the task is blocked
+ * on an event group, so it does not wake the CPU until the next timer is due or an event is signalled.
+ *
+ * Callbacks run one after another on the loop task, a long callback delays the others (blocking work belongs
+ * to its own task). The task is started by the first registered timer or event.
+ * */
+class EventLoop {
+public:
+    typedef uint32_t TimerId;
+    static constexpr uint32_t TICK_MS = 10;
+
+    EventLoop(const Tasker &tasker, const char *name, TaskOptions options = {});
+
+    /**
+     * Calls `callback` once after `millis` ms. Can be called from any task.
+     * */
+    TimerId after(uint32_t millis, std::function<void(void)> callback);
+
+    /**
+     * Calls `callback` every `millis` ms, the first time after `millis` ms. Can be called from any task.
+     * */
+    TimerId every(uint32_t millis, std::function<void(void)> callback);
+
+    /**
+     * Stops the timer. A call which is already due may still run.
+     * */
+    void cancel(TimerId timer);
+
+    /**
+     * Registers a handler called on the loop task whenever the returned bit is signalled.
+     *
+     * @return event bit for `signal()`, 0 if all bits are taken
+     * */
+    EventBits_t onEvent(std::function<void(void)> handler);
+
+    /**
+     * Wakes the loop to run handlers of `bits`. Signals coming before the handler runs are merged.
+     * */
+    void signal(EventBits_t bits);
+
+    void signalFromISR(EventBits_t bits);
+
+private:
+    static constexpr int LEVELS = 3;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1 << SLOT_BITS;
+    static constexpr EventBits_t WAKE_BIT = 1 << 23; // timers changed, deadline must be recomputed
+    static constexpr int USER_BITS = 23;
+
+    typedef std::shared_ptr<std::function<void(void)>> Callback; // copied to the loop without allocation
+
+    struct Timer {
+        uint32_t expires; // tick
+        uint32_t period; // ticks, 0 for one-shot timers
+        Callback callback;
+    };
+
+    void start();
+
+    [[noreturn]] void run();
+
+    TimerId add(uint32_t millis, uint32_t period, std::function<void(void)> callback);
+
+    /**
+     * Puts the timer into the slot of its expiration. Caller holds `timersMutex`.
+     * */
+    void schedule(TimerId id, uint32_t expires);
+
+    /**
+     * Fires timers due up to `now` (ticks), cascading the upper levels on the way.
+     * */
+    void advance(uint32_t now);
+
+    /**
+     * Moves timers of the actual slot of `level` to the lower levels. Caller holds `timersMutex`.
+     * */
+    void cascade(int level);
+
+    /**
+     * @return ticks until the earliest non-empty slot or cascade of an upper level, UINT32_MAX if there is none.
+     * Caller holds `timersMutex`.
+     * */
+    uint32_t ticksToNextSlot() const;
+
+    static uint32_t nowTicks();
+
+    const Tasker &tasker;
+    const char *name;
+    TaskOptions options;
+    TaskHandle task;
+    EventGroupHandle_t events = nullptr;
+    std::once_flag started;
+
+    std::mutex timersMutex;
+    std::map<TimerId, Timer> timers;
+    std::vector<TimerId> wheel[LEVELS][SLOTS];
+    uint32_t current = 0; // the next tick to process
+    TimerId nextId = 1;
+
+    std::mutex handlersMutex;
+    std::vector<Callback> handlers; // index is the event bit
+};
+
+extern EventLoop DefaultEventLoop;
+
+#endif //SOUNDBOX_EVENTLOOP_H
@@ -0,0 +1,142 @@
+#ifndef ESP_PLATFORM
+
+#include "HostRtos.h"
+#include <algorithm>
+#include <chrono>
+
+struct HostEventGroup {
+    EventBits_t bits = 0; // guarded by the clock lock
+};
+
+std::mutex &HostClock::mutex = *new std::mutex();
+std::condition_variable &HostClock::changed = *new std::condition_variable();
+bool HostClock::virtualTime = false;
+int64_t HostClock::virtualNow = 0;
+std::list<HostClock::Waiter *> &HostClock::waiters = *new std::list<Waiter *>();
+uint32_t HostClock::generation = 0;
+size_t HostClock::tasks = 0;
+
+static int64_t realNow() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int64_t HostClock::now() {
+    std::lock_guard<std::mutex> lg(mutex);
+    return virtualTime ? virtualNow : realNow();
+}
+
+void HostClock::useVirtualTime() {
+    std::lock_guard<std::mutex> lg(mutex);
+    virtualTime = true;
+    virtualNow = 0;
+}
+
+void HostClock::advance(int64_t us) {
+    std::unique_lock<std::mutex> lock(mutex);
+    int64_t target = virtualNow + us;
+    for (;;) {
+        changed.wait(lock, settled);
+        int64_t next = nextDeadline();
+        if (next > target) break;
+        virtualNow = std::max(virtualNow, next);
+        generation++;
+        changed.notify_all();
+    }
+    virtualNow = target;
+}
+
+void HostClock::settle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, settled);
+}
+
+void HostClock::attach() {
+    notify([] { tasks++; });
+}
+
+void HostClock::detach() {
+    notify([] { tasks--; });
+}
+
+bool HostClock::waitUntil(int64_t deadline, const std::function<bool(void)> &condition) {
+    std::unique_lock<std::mutex> lock(mutex);
+    Waiter waiter{deadline, 0};
+    auto position = waiters.insert(waiters.end(), &waiter);
+    bool satisfied;
+    for (;;) {
+        waiter.checked = generation;
+        if ((satisfied = condition())) break;
+        int64_t current = virtualTime ? virtualNow : realNow();
+        if (current >= deadline) break;
+        changed.notify_all(); // this task may have settled
+        if (virtualTime || deadline == INT64_MAX) {
+            changed.wait(lock);
+        } else {
+            changed.wait_for(lock, std::chrono::microseconds(deadline - current));
+        }
+    }
+    waiters.erase(position);
+    return satisfied;
+}
+
+void HostClock::sleepUntil(int64_t deadline) {
+    waitUntil(deadline, [] { return false; });
+}
+
+void HostClock::notify(const std::function<void(void)> &change) {
+    {
+        std::lock_guard<std::mutex> lg(mutex);
+        change();
+        generation++;
+    }
+    changed.notify_all();
+}
+
+bool HostClock::settled() {
+    if (waiters.size() < tasks) return false;
+    for (const Waiter *waiter: waiters) {
+        if (waiter->checked != generation || waiter->deadline <= virtualNow) return false;
+    }
+    return true;
+}
+
+int64_t HostClock::nextDeadline() {
+    int64_t next = INT64_MAX;
+    for (const Waiter *waiter: waiters) {
+        next = std::min(next, waiter->deadline);
+    }
+    return next;
+}
+
+EventGroupHandle_t xEventGroupCreate() {
+    return new HostEventGroup();
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    EventBits_t result;
+    HostClock::notify([&] { result = group->bits |= bits; });
+    return result;
+}
+
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t group, EventBits_t bits, BaseType_t *woken) {
+    xEventGroupSetBits(group, bits);
+    *woken = pdFALSE;
+    return pdPASS;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t timeout) {
+    EventBits_t result = 0;
+    auto condition = [&] {
+        result = group->bits;
+        bool met = waitForAll ? (result & bits) == bits : (result & bits) != 0;
+        if (met && clearOnExit) group->bits &= ~bits;
+        return met;
+    };
+    int64_t deadline = timeout == portMAX_DELAY ? INT64_MAX : HostClock::now() + (int64_t) timeout * 1000;
+    HostClock::waitUntil(deadline, condition);
+    return result;
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef SOUNDBOX_HOSTRTOS_H
+#define SOUNDBOX_HOSTRTOS_H
+
+#ifndef ESP_PLATFORM
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+
+/**
+ * The part of FreeRTOS and ESP-IDF used by `Tasker` and `EventLoop`, implemented on the host (Linux) by std::thread,
+ * so code built on them can run and be tested off-target.
+ *
+ * All waiting goes through `HostClock`. By default it follows the real time; with virtual time the clock stands
+ * still until `HostClock::advance()` moves it, deadline by deadline, letting all tasks run to their next wait after
+ * each step. Schedules are then deterministic and a minute of the tracker takes milliseconds.
+ * */
+typedef unsigned int UBaseType_t;
+typedef int BaseType_t;
+typedef void *TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef uint32_t EventBits_t;
+typedef struct HostEventGroup *EventGroupHandle_t;
+
+#define pdPASS 1
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY UINT32_MAX
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define portYIELD_FROM_ISR()
+#define tskIDLE_PRIORITY 0
+
+class HostClock {
+public:
+    /**
+     * @return time since start in us (virtual or real)
+     * */
+    static int64_t now();
+
+    /**
+     * Switches to virtual time starting at 0. Call before any task is started.
+     * */
+    static void useVirtualTime();
+
+    /**
+     * Moves the virtual time forward. Stops at every deadline on the way, wakes its tasks and waits until all tasks
+     * are waiting again (see `settle()`).
+     * */
+    static void advance(int64_t us);
+
+    /**
+     * Blocks until every task waits for a future deadline or an unmet condition. A task blocked outside of
+     * `HostClock` (e.g. on a std::mutex held by the caller) never settles.
+     * */
+    static void settle();
+
+    /**
+     * Counts the calling thread as a task, `Tasker` calls these.
+     * */
+    static void attach();
+    static void detach();
+
+    /**
+     * Blocks until `condition` holds (checked whenever `notify()` is called) or until `deadline` (us).
+     *
+     * @return false on timeout
+     * */
+    static bool waitUntil(int64_t deadline, const std::function<bool(void)> &condition);
+
+    static void sleepUntil(int64_t deadline);
+
+    /**
+     * Runs `change` under the clock lock and wakes the waiting tasks to check their conditions.
+     * */
+    static void notify(const std::function<void(void)> &change);
+
+private:
+    struct Waiter {
+        int64_t deadline;
+        uint32_t checked; // `generation` at the last check of the condition
+    };
+
+    static bool settled();
+    static int64_t nextDeadline();
+
+    // never destroyed, tasks may still be waiting when the process exits
+    static std::mutex &mutex;
+    static std::condition_variable &changed;
+    static bool virtualTime;
+    static int64_t virtualNow;
+    static std::list<Waiter *> &waiters;
+    static uint32_t generation; // of changes, see `notify()`
+    static size_t tasks;
+};
+
+inline int64_t esp_timer_get_time() {
+    return HostClock::now();
+}
+
+EventGroupHandle_t xEventGroupCreate();
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t group, EventBits_t bits, BaseType_t *woken);
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t timeout);
+
+#endif
+
+#endif //SOUNDBOX_HOSTRTOS_H
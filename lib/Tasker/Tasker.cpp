@@ -1,57 +1,151 @@
-#include <Arduino.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#ifndef ESP_PLATFORM
+#include <thread>
+#endif
 
 #include "Tasker.h"
 
-Tasker::Tasker(int core) {
-    this->core = core;
+// running tasks; the FreeRTOS task removes itself (and clears its handle) right before it is deleted
+static std::mutex registryMutex;
+static std::vector<TaskHandle> registry;
+
+Task::Task(const char *name, std::function<void(void)> op, int period) :
+        name(name),
+        op(std::move(op)),
+        period(period) {}
+
+const char *Task::getName() const {
+    return name;
+}
+
+void Task::cancel() {
+    cancelled = true;
+}
+
+bool Task::isCancelled() const {
+    return cancelled;
+}
+
+bool Task::isRunning() const {
+    std::lock_guard<std::mutex> lg(registryMutex);
+    return handle != nullptr;
+}
+
+uint32_t Task::getStackHighWaterMark() const {
+    std::lock_guard<std::mutex> lg(registryMutex);
+#ifdef ESP_PLATFORM
+    return handle == nullptr ? 0 : uxTaskGetStackHighWaterMark(handle); // ESP-IDF counts the stack in bytes
+#else
+    return 0;
+#endif
+}
+
+int64_t Task::getCpuTime() const {
+#if defined(ESP_PLATFORM) && configGENERATE_RUN_TIME_STATS == 1 && configUSE_TRACE_FACILITY == 1
+    std::lock_guard<std::mutex> lg(registryMutex);
+    if (handle != nullptr) {
+        TaskStatus_t status;
+        vTaskGetInfo(handle, &status, pdFALSE, eInvalid);
+        cpuTime += (uint32_t) (status.ulRunTimeCounter - lastRunTimeCounter);
+        lastRunTimeCounter = status.ulRunTimeCounter;
+    }
+    return (int64_t) cpuTime;
+#else
+    return -1;
+#endif
+}
+
+uint32_t Task::getIterations() const {
+    return iterations;
 }
 
-[[noreturn]] static void executeLoop(void *uarg) {
-    auto *fnc_ptr = static_cast<std::function<void(void)> *>(uarg);
-    auto fnc = std::move(*fnc_ptr);
-    delete fnc_ptr;
+void Task::run(void *arg) {
+    auto *task = static_cast<Task *>(arg);
+    do {
+        task->op();
+        task->iterations++;
+        if (task->period >= 0) {
+            Tasker::yield();
+        }
+        if (task->period > 0) {
+            Tasker::sleep(task->period);
+        }
+    } while (task->period >= 0 && !task->cancelled);
 
-    for (;;) {
-        fnc();
+    {
+        std::lock_guard<std::mutex> lg(registryMutex);
+        task->handle = nullptr;
+        registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                      [task](const TaskHandle &t) { return t.get() == task; }), registry.end());
+        // `task` may be deleted now
     }
+#ifdef ESP_PLATFORM
+    vTaskDelete(nullptr);
+#endif
 }
 
-void execute(void *uarg) {
-    auto *fnc_ptr = static_cast<std::function<void(void)> *>(uarg);
-    auto fnc = std::move(*fnc_ptr);
-    delete fnc_ptr;
+Tasker::Tasker(int core) {
+    this->core = core;
+}
 
-    fnc();
+TaskHandle Tasker::once(const char *name, std::function<void(void)> op, TaskOptions options) const {
+    return start(name, -1, std::move(op), options);
 }
 
-void Tasker::loop(const char *name, std::function<void(void)> op) const {
-    auto *fnc = new std::function<void(void)>{[op] {
-        op();
-        Tasker::yield();
-    }};
-    xTaskCreatePinnedToCore(executeLoop, name, 10000, static_cast<void *>(fnc), 1, NULL, core);
+TaskHandle Tasker::loop(const char *name, std::function<void(void)> op, TaskOptions options) const {
+    return start(name, 0, std::move(op), options);
 }
 
-void Tasker::loopEvery(const char *name, int millis, std::function<void(void)> op) const {
-    auto *fnc = new std::function<void(void)>{[op, millis] {
-        op();
-        Tasker::yield();
-        Tasker::sleep(millis);
-    }};
-    xTaskCreatePinnedToCore(executeLoop, name, 10000, static_cast<void *>(fnc), 1, NULL, core);
+TaskHandle Tasker::loopEvery(const char *name, int millis, std::function<void(void)> op, TaskOptions options) const {
+    return start(name, std::max(millis, 1), std::move(op), options);
 }
 
-void Tasker::once(const char *name, std::function<void(void)> op) const {
-    auto *fnc = new std::function<void(void)>{[op] {
-        op();
-        vTaskDelete(NULL);
-    }};
-    xTaskCreatePinnedToCore(execute, name, 10000, static_cast<void *>(fnc), 1, NULL, core);
+TaskHandle Tasker::start(const char *name, int period, std::function<void(void)> op,
+                         const TaskOptions &options) const {
+    TaskHandle task(new Task(name, std::move(op), period));
+    // the registry lock keeps the new task from finishing before its handle is stored
+    std::lock_guard<std::mutex> lg(registryMutex);
+#ifdef ESP_PLATFORM
+    if (xTaskCreatePinnedToCore(Task::run, name, options.stackSize, task.get(), options.priority, &task->handle,
+                                core) != pdPASS) {
+        task->handle = nullptr;
+        return task;
+    }
+#else
+    task->handle = task.get(); // anything but nullptr marks a running task
+    // the thread holds its task, threads still running when the process exits outlive the registry
+    HostClock::attach();
+    std::thread([task] {
+        Task::run(task.get());
+        HostClock::detach();
+    }).detach();
+#endif
+    registry.push_back(task);
+    return task;
+}
+
+std::vector<TaskHandle> Tasker::tasks() {
+    std::lock_guard<std::mutex> lg(registryMutex);
+    return registry;
+}
+
+TaskHandle Tasker::find(const char *name) {
+    std::lock_guard<std::mutex> lg(registryMutex);
+    for (const auto &task: registry) {
+        if (strcmp(task->name, name) == 0) return task;
+    }
+    return nullptr;
 }
 
 void Tasker::sleep(int millis) {
+#ifdef ESP_PLATFORM
     taskYIELD();
     vTaskDelay(pdMS_TO_TICKS(millis));
+#else
+    HostClock::sleepUntil(HostClock::now() + (int64_t) millis * 1000);
+#endif
 }
 
 void Tasker::yield() {
@@ -1,27 +1,108 @@
 #ifndef SOUNDBOX_TASKER_H
 #define SOUNDBOX_TASKER_H
 
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#else
+#include "HostRtos.h"
+#endif
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <vector>
 
+struct TaskOptions {
+    uint32_t stackSize = 10000; // in bytes, see `Task::getStackHighWaterMark()` for sizing
+    UBaseType_t priority = 1;
+};
+
+/**
+ * Task created by `Tasker`. The object outlives the FreeRTOS task as long as somebody holds its handle.
+ * */
+class Task {
+public:
+    const char *getName() const;
+
+    /**
+     * Asks the task to stop. Loops stop before the next iteration, `once` tasks should check `isCancelled()`.
+     * */
+    void cancel();
+
+    bool isCancelled() const;
+
+    bool isRunning() const;
+
+    /**
+     * @return the least free stack ever (bytes), 0 if the task is not running (and always on the host)
+     * */
+    uint32_t getStackHighWaterMark() const;
+
+    /**
+     * Reads the FreeRTOS run-time statistics (`configGENERATE_RUN_TIME_STATS`, counted by `esp_timer`), their 32-bit
+     * counter wraps every 71 minutes, so call this at least once an hour.
+     *
+     * @return time the task ran on the CPU (us), -1 if the statistics are not collected (and always on the host)
+     * */
+    int64_t getCpuTime() const;
+
+    /**
+     * @return finished calls of the task's function, a `once` task has none until it returns
+     * */
+    uint32_t getIterations() const;
+
+private:
+    friend class Tasker;
+
+    Task(const char *name, std::function<void(void)> op, int period);
+
+    static void run(void *arg);
+
+    const char *name;
+    std::function<void(void)> op;
+    int period; // ms between iterations, 0 for `loop`, negative for `once`
+    TaskHandle_t handle = nullptr; // guarded by the registry lock
+    std::atomic<bool> cancelled{false};
+    mutable uint64_t cpuTime = 0; // guarded by the registry lock
+    mutable uint32_t lastRunTimeCounter = 0; // guarded by the registry lock
+    std::atomic<uint32_t> iterations{0};
+};
+
+typedef std::shared_ptr<Task> TaskHandle;
+
+/**
+ * Creates tasks pinned to a core. On the host (see `HostRtos.h`) tasks are threads, cores, priorities and stack sizes
+ * are ignored and all sleeping follows `HostClock`.
+ * */
 class Tasker {
 public:
     explicit Tasker(int core);
 
-    void once(const char *name, std::function<void(void)> op) const;
+    TaskHandle once(const char *name, std::function<void(void)> op, TaskOptions options = {}) const;
+
+    TaskHandle loop(const char *name, std::function<void(void)> op, TaskOptions options = {}) const;
 
-    void loop(const char *name, std::function<void(void)> op) const;
+    TaskHandle loopEvery(const char *name, int millis, std::function<void(void)> op, TaskOptions options = {}) const;
 
-    void loopEvery(const char *name, int millis, std::function<void(void)> op) const;
+    /**
+     * @return all running tasks (of both taskers)
+     * */
+    static std::vector<TaskHandle> tasks();
+
+    /**
+     * @return running task of the name or nullptr
+     * */
+    static TaskHandle find(const char *name);
 
     static void sleep(int millis);
     static void yield();
 
 private:
+    TaskHandle start(const char *name, int period, std::function<void(void)> op, const TaskOptions &options) const;
+
     int core;
 };
 
 extern Tasker DefaultTasker;
 extern Tasker SoundTasker;
 
-#endif //SOUNDBOX_TASKER_H
\ No newline at end of file
+#endif //SOUNDBOX_TASKER_H
@@ -0,0 +1,32 @@
+"""
+PlatformIO monitor filter decoding binary logs of the tracker (see tools/logdecoder.py).
+
+It must be the first filter and the monitor must use `monitor_encoding = latin-1`, so the binary frames
+reach it unchanged.
+"""
+
+import io
+import os
+import sys
+
+from platformio.public import DeviceMonitorFilterBase
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools"))
+import logdecoder  # noqa: E402
+
+
+class LogDecoder(DeviceMonitorFilterBase):
+    NAME = "logdecoder"
+
+    def __call__(self):
+        elf = os.path.join(self.project_dir, ".pio", "build", self.environment, "firmware.elf")
+        self.buffer = io.StringIO()
+        self.decoder = logdecoder.Decoder(logdecoder.Elf(elf), self.buffer)
+        return self
+
+    def rx(self, text):
+        self.decoder.feed(text.encode("latin-1"))
+        decoded = self.buffer.getvalue()
+        self.buffer.seek(0)
+        self.buffer.truncate()
+        return decoded
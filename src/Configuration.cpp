@@ -0,0 +1,149 @@
+#include "Configuration.h"
+#include "WaypointReader.h"
+
+// settings sections only (strings of mqtt/gsm config are the biggest part)
+static const size_t SETTINGS_CAPACITY = 2048;
+
+bool GPS_TRACKER::Configuration::read() {
+    if (!readGamePack()) {
+        return readFile(CONFIG_PATH) || readFile(CONFIG_BACKUP_PATH);
+    }
+    if (isGamePackOverridden(gamePack->header().crc)) {
+        // read aside, the pack stays if the file is broken
+        Configuration downlinked;
+        if (downlinked.readFile(CONFIG_PATH) || downlinked.readFile(CONFIG_BACKUP_PATH)) {
+            *this = downlinked;
+        }
+    }
+    return true;
+}
+
+bool GPS_TRACKER::Configuration::readFile(const std::string &path) {
+    if (!SPIFFS.exists(path.c_str())) {
+        return false;
+    }
+    File configFile = SPIFFS.open(path.c_str());
+    if (!configFile) {
+        return false;
+    }
+    gamePack.reset();
+    configFile.setTimeout(0); // reads from flash never wait for data, end of the file is really the end
+    bool result = readSettings(configFile) && readWaypoints(configFile);
+    configFile.close();
+    return result;
+}
+
+bool GPS_TRACKER::Configuration::isFromGamePack() const {
+    return gamePack != nullptr;
+}
+
+bool GPS_TRACKER::Configuration::overrideGamePack() const {
+    if (!gamePack) {
+        return true; // the pack is not used or `config.json` already supersedes it
+    }
+    uint32_t crc = gamePack->header().crc;
+    File file = SPIFFS.open(CONFIG_OVERRIDE_PATH.c_str(), FILE_WRITE);
+    if (!file) {
+        return false;
+    }
+    bool written = file.write((const uint8_t *) &crc, sizeof(crc)) == sizeof(crc);
+    file.close();
+    return written;
+}
+
+bool GPS_TRACKER::Configuration::isGamePackOverridden(uint32_t crc) {
+    if (!SPIFFS.exists(CONFIG_OVERRIDE_PATH.c_str())) {
+        return false;
+    }
+    File file = SPIFFS.open(CONFIG_OVERRIDE_PATH.c_str());
+    uint32_t overridden = 0;
+    bool complete = file && file.read((uint8_t *) &overridden, sizeof(overridden)) == sizeof(overridden);
+    file.close();
+    return complete && overridden == crc;
+}
+
+bool GPS_TRACKER::Configuration::readGamePack() {
+    auto pack = std::make_shared<GamePack>();
+    if (!pack->map()) {
+        return false;
+    }
+
+    const GamePackHeader &header = pack->header();
+    DynamicJsonDocument doc(SETTINGS_CAPACITY);
+    if (deserializeJson(doc, pack->settings(), header.settingsSize) != DeserializationError::Ok) {
+        return false;
+    }
+    applySettings(doc);
+
+    // waypoints are read in place, nothing is copied to RAM
+    WAYPOINTS.map(pack->lats(), pack->lons(), pack->ids(), pack->pathIndexes(), header.waypointsCount,
+                  pack->pathData(), pack->pathOffsets(), header.pathsCount);
+    gamePack = pack;
+    return true;
+}
+
+bool GPS_TRACKER::Configuration::readSettings(File &file) {
+    StaticJsonDocument<256> filter;
+    filter["general"] = true;
+    filter["mqtt"] = true;
+    filter["gsm"] = true;
+    filter["gps"] = true;
+    filter["sleep"] = true;
+    filter["report"] = true;
+    filter["motion"] = true;
+    filter["diagnostics"] = true;
+    filter["audio"] = true;
+
+    DynamicJsonDocument doc(SETTINGS_CAPACITY);
+    file.seek(0);
+    DeserializationError error = deserializeJson(doc, file, DeserializationOption::Filter(filter));
+    if (error != DeserializationError::Ok) {
+        return false;
+    }
+    applySettings(doc);
+    return true;
+}
+
+void GPS_TRACKER::Configuration::applySettings(JsonDocument &doc) {
+    JsonVariant generalConfig = doc["general"];
+    JsonVariant mqttConfiguration = doc["mqtt"];
+    JsonVariant gsmConfig = doc["gsm"];
+    JsonVariant gpsConfig = doc["gps"];
+    JsonVariant sleepConfig = doc["sleep"];
+    JsonVariant reportConfig = doc["report"];
+    JsonVariant motionConfig = doc["motion"];
+    JsonVariant diagnosticsConfig = doc["diagnostics"];
+    JsonVariant audioConfig = doc["audio"];
+
+    GPS_CONFIG = gps_config::build(gpsConfig);
+    GSM_CONFIG = gsm_config::build(gsmConfig);
+    MQTT_CONFIG = mqtt_config::build(mqttConfiguration);
+    CONFIG = config::build(generalConfig);
+    SLEEP_CONFIG = sleep_config::build(sleepConfig);
+    REPORT_CONFIG = report_config::build(reportConfig);
+    MOTION_CONFIG = motion_config::build(motionConfig);
+    DIAGNOSTICS_CONFIG = diagnostics_config::build(diagnosticsConfig);
+    AUDIO_CONFIG = audio_config::build(audioConfig);
+}
+
+bool GPS_TRACKER::Configuration::readWaypoints(File &file) {
+    // first pass only counts the waypoints, so the vector is allocated exactly once
+    size_t count = 0;
+    file.seek(0);
+    if (!WaypointReader::forEachWaypoint(file, [&count](JsonObject) { count++; })) {
+        return false;
+    }
+
+    WAYPOINTS.clear();
+    WAYPOINTS.reserve(count);
+    bool stored = true;
+    file.seek(0);
+    bool parsed = WaypointReader::forEachWaypoint(file, [this, &stored](JsonObject v) {
+        size_t id = v["id"];
+        double lat = v["lat"];
+        double lon = v["lon"];
+        const char *path = v["path"] | "";
+        stored = WAYPOINTS.add(id, lat, lon, path) && stored;
+    });
+    return parsed && stored;
+}
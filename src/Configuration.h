@@ -4,170 +4,76 @@
 #include <utility>
 #include <map>
 #include <queue>
+#include <functional>
+#include <memory>
 
 #include "SPIFFS.h"
 #include "ArduinoJson.h"
+#include "ConfigurationSections.h"
 #include "Constants.h"
+#include "Waypoints.h"
+#include "GamePack.h"
 #include "string"
 
 namespace GPS_TRACKER {
-    struct gps_config {
-        explicit gps_config() = default;
-
-        gps_config(bool enable, int samplingRate, bool fastFix, double minimalAccuracy, int positionSampleFrequency,
-                   int noPositionsInReport) :
-                enable(enable),
-                samplingRate(samplingRate),
-                fastFix(fastFix),
-                minimal_accuracy(minimalAccuracy),
-                positionSampleFrequency(positionSampleFrequency),
-                noPositionsInReport(noPositionsInReport) {}
-
-        static gps_config build(JsonVariant &c) {
-            return {
-                    c["enable"].as<bool>(),
-                    c["sampling-rate"].as<int>(),
-                    c["fast-fix"].as<bool>(),
-                    c["minimal-accuracy"].as<double>(),
-                    c["positions-in-report"].as<int>(),
-                    c["positions-in-report"].as<int>()
-            };
-        }
-
-        bool enable = false;
-        int samplingRate = 1000;
-        bool fastFix = false;
-        double minimal_accuracy = 0;
-        int positionSampleFrequency = 1;
-        int noPositionsInReport = 2;
-    };
-
-    struct gsm_config {
-        explicit gsm_config() = default;
-
-        gsm_config(bool enable, std::string apn, std::string user, std::string password) : enable(
-                enable), apn(std::move(apn)), user(std::move(user)), password(std::move(password)) {}
-
-        static gsm_config build(JsonVariant &c) {
-            return gsm_config(
-                    c["enable"].as<bool>(),
-                    c["apn"].as<std::string>(),
-                    c["user"].as<std::string>(),
-                    c["password"].as<std::string>()
-            );
-        }
-
-        bool enable = false;
-        std::string apn;
-        std::string user;
-        std::string password;
-    };
-
-    struct mqtt_config {
-        mqtt_config() = default;
-
-        mqtt_config(std::string topic, std::string host, std::string username,
-                    std::string password, int port) : topic(std::move(topic)), host(std::move(host)),
-                                                      username(std::move(username)),
-                                                      password(std::move(password)), port(port) {}
-
-        static mqtt_config build(JsonVariant &c) {
-            return mqtt_config(
-                    c["topic"].as<std::string>(),
-                    c["host"].as<std::string>(),
-                    c["username"].as<std::string>(),
-                    c["password"].as<std::string>(),
-                    c["port"].as<int>()
-            );
-        }
-
-        std::string topic;
-        std::string host;
-        std::string username;
-        std::string password;
-        int port = 8883;
-    };
-
-    struct config {
-        config() = default;
-
-        config(long trackerId, std::string token, double accuracy, long sleepTime) : trackerId(trackerId),
-                                                                                     accuracy(accuracy),
-                                                                                     token(std::move(token)),
-                                                                                     sleepTime(sleepTime) {}
-
-        static config build(JsonVariant &c) {
-            return config(
-                    c["tracker-id"].as<long>(),
-                    c["token"].as<std::string>(),
-                    c["accuracy"].as<double>(),
-                    c["sleep-time"].as<long>()
-            );
-        }
-
-        long trackerId = -1;
-        double accuracy = 100;
-        std::string token;
-        long sleepTime = 0; // in seconds
-    };
-
-    struct waypoint {
-        waypoint(size_t id, float lat, float lon, std::string path) : id(id), lat(lat), lon(lon),
-                                                                      path(std::move(path)) {}
-
-        size_t id;
-        float lat;
-        float lon;
-        std::string path;
-    };
-
-    using waypoints = std::vector<waypoint>;
-
     class Configuration {
     public:
         /**
-         * This functions is accessing configuration file on external storage.
+         * The newest configuration format this firmware understands.
          * */
-        bool read() {
-            DynamicJsonDocument doc(2048);
-
-            // read config from filesystem
-            File configFile = SPIFFS.open(CONFIG_PATH.c_str());
-            DeserializationError error = deserializeJson(doc, configFile);
-            configFile.close();
+        static constexpr int SCHEMA_VERSION = 1;
 
-            if (error != DeserializationError::Ok) {
-                return false;
-            }
-
-            // parsing
-            JsonVariant generalConfig = doc["general"];
-            JsonVariant mqttConfiguration = doc["mqtt"];
-            JsonVariant gsmConfig = doc["gsm"];
-            JsonVariant gpsConfig = doc["gps"];
-            JsonArray waypoints = doc["waypoints"].as<JsonArray>();
+        /**
+         * Reads the game pack from its partition, falls back to the configuration file on external storage
+         * (and to its backup when the tracker was reset in the middle of an update). The file is preferred over
+         * the pack when it was replaced while this very pack was in use, see `overrideGamePack()`.
+         * */
+        bool read();
 
-            GPS_CONFIG = gps_config::build(gpsConfig);
-            GSM_CONFIG = gsm_config::build(gsmConfig);
-            MQTT_CONFIG = mqtt_config::build(mqttConfiguration);
-            CONFIG = config::build(generalConfig);
+        /**
+         * Reads the configuration file at `path`.
+         *
+         * The file is streamed: settings sections are deserialized with a filter (waypoints are skipped) and
+         * waypoints are parsed one by one, so the peak heap usage does not depend on the number of waypoints.
+         * */
+        bool readFile(const std::string &path);
 
-            for (JsonVariant v: waypoints) {
-                size_t id = v["id"];
-                std::string path = v["path"];
-                float lat = v["lat"];
-                float lon = v["lon"];
-                WAYPOINTS.push_back(waypoint(id, lat, lon, path));
-            }
+        /**
+         * @return true if the configuration was read from the precompiled game pack (not from `config.json`)
+         * */
+        [[nodiscard]] bool isFromGamePack() const;
 
-            return true;
-        }
+        /**
+         * Makes `config.json` supersede the game pack this configuration was read from on the next boots. A pack
+         * flashed later (another CRC) takes precedence again. Called when `config.json` replaced this configuration.
+         *
+         * @return false if the preference could not be stored
+         * */
+        [[nodiscard]] bool overrideGamePack() const;
 
         gps_config GPS_CONFIG;
         gsm_config GSM_CONFIG;
         mqtt_config MQTT_CONFIG;
         config CONFIG;
-        waypoints WAYPOINTS;
+        sleep_config SLEEP_CONFIG;
+        report_config REPORT_CONFIG;
+        motion_config MOTION_CONFIG;
+        diagnostics_config DIAGNOSTICS_CONFIG;
+        audio_config AUDIO_CONFIG;
+        Waypoints WAYPOINTS;
+
+    private:
+        bool readGamePack();
+
+        static bool isGamePackOverridden(uint32_t crc);
+
+        bool readSettings(File &file);
+
+        void applySettings(JsonDocument &doc);
+
+        bool readWaypoints(File &file);
+
+        std::shared_ptr<GamePack> gamePack; // mapping must live as long as any copy of the waypoints
     };
 }
 
@@ -0,0 +1,260 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_CONFIGURATIONSECTIONS_H
+#define LIGHTWEIGHT_GPS_TRACKER_CONFIGURATIONSECTIONS_H
+
+#include <string>
+#include <utility>
+#include "ArduinoJson.h"
+
+/**
+ * Sections of `config.json`, plain values without any storage (see `Configuration`), so they build for the host too.
+ * */
+namespace GPS_TRACKER {
+    struct gps_config {
+        explicit gps_config() = default;
+
+        gps_config(bool enable, int samplingRate, bool fastFix, double minimalAccuracy, int positionSampleFrequency,
+                   int noPositionsInReport, float uere, float processNoise, float outlierGate, int maxRejected) :
+                enable(enable),
+                samplingRate(samplingRate),
+                fastFix(fastFix),
+                minimal_accuracy(minimalAccuracy),
+                positionSampleFrequency(positionSampleFrequency),
+                noPositionsInReport(noPositionsInReport),
+                uere(uere),
+                processNoise(processNoise),
+                outlierGate(outlierGate),
+                maxRejected(maxRejected) {}
+
+        static gps_config build(JsonVariant &c) {
+            return {
+                    c["enable"].as<bool>(),
+                    c["sampling-rate"].as<int>(),
+                    c["fast-fix"].as<bool>(),
+                    c["minimal-accuracy"].as<double>(),
+                    c["positions-in-report"].as<int>(),
+                    c["positions-in-report"].as<int>(),
+                    c["uere"] | 4.0f,
+                    c["process-noise"] | 1.0f,
+                    c["outlier-gate"] | 9.21f,
+                    c["max-rejected"] | 5
+            };
+        }
+
+        bool enable = false;
+        int samplingRate = 1000;
+        bool fastFix = false;
+        double minimal_accuracy = 0; // HDOP, the filtered estimate must be better than `minimal_accuracy * uere` meters
+        int positionSampleFrequency = 1;
+        int noPositionsInReport = 2;
+        float uere = 4; // user equivalent range error in meters
+        float processNoise = 1; // in m^2/s^3
+        float outlierGate = 9.21; // chi-square, 2 DOF, 99 %
+        int maxRejected = 5;
+    };
+
+    struct gsm_config {
+        explicit gsm_config() = default;
+
+        gsm_config(bool enable, std::string apn, std::string user, std::string password) : enable(
+                enable), apn(std::move(apn)), user(std::move(user)), password(std::move(password)) {}
+
+        static gsm_config build(JsonVariant &c) {
+            return gsm_config(
+                    c["enable"].as<bool>(),
+                    c["apn"].as<std::string>(),
+                    c["user"].as<std::string>(),
+                    c["password"].as<std::string>()
+            );
+        }
+
+        bool enable = false;
+        std::string apn;
+        std::string user;
+        std::string password;
+    };
+
+    struct mqtt_config {
+        mqtt_config() = default;
+
+        mqtt_config(std::string topic, std::string host, std::string username,
+                    std::string password, int port) : topic(std::move(topic)), host(std::move(host)),
+                                                      username(std::move(username)),
+                                                      password(std::move(password)), port(port) {}
+
+        static mqtt_config build(JsonVariant &c) {
+            return mqtt_config(
+                    c["topic"].as<std::string>(),
+                    c["host"].as<std::string>(),
+                    c["username"].as<std::string>(),
+                    c["password"].as<std::string>(),
+                    c["port"].as<int>()
+            );
+        }
+
+        std::string topic;
+        std::string host;
+        std::string username;
+        std::string password;
+        int port = 8883;
+    };
+
+    struct config {
+        config() = default;
+
+        config(long trackerId, std::string token, double accuracy, long sleepTime, int schemaVersion) :
+                trackerId(trackerId),
+                accuracy(accuracy),
+                token(std::move(token)),
+                sleepTime(sleepTime),
+                schemaVersion(schemaVersion) {}
+
+        static config build(JsonVariant &c) {
+            return config(
+                    c["tracker-id"].as<long>(),
+                    c["token"].as<std::string>(),
+                    c["accuracy"].as<double>(),
+                    c["sleep-time"].as<long>(),
+                    c["schema-version"] | 1
+            );
+        }
+
+        long trackerId = -1;
+        double accuracy = 100;
+        std::string token;
+        long sleepTime = 0; // in seconds
+        int schemaVersion = 1; // version of the configuration format, see `Configuration::SCHEMA_VERSION`
+    };
+
+    struct sleep_config {
+        explicit sleep_config() = default;
+
+        sleep_config(double safetyMargin, double assumedSpeed, long minimalSleepTime, long wakeUpOverhead,
+                     int fastSamplingRate, int slowSamplingRate) :
+                safetyMargin(safetyMargin),
+                assumedSpeed(assumedSpeed),
+                minimalSleepTime(minimalSleepTime),
+                wakeUpOverhead(wakeUpOverhead),
+                fastSamplingRate(fastSamplingRate),
+                slowSamplingRate(slowSamplingRate) {}
+
+        static sleep_config build(JsonVariant &c) {
+            return {
+                    c["safety-margin"] | 2.0,
+                    c["assumed-speed"] | 2.0,
+                    c["minimal-sleep-time"] | 5L,
+                    c["wake-up-overhead"] | 3L,
+                    c["fast-sampling-rate"] | 500,
+                    c["slow-sampling-rate"] | 2000
+            };
+        }
+
+        double safetyMargin = 2.0; // multiplier of the estimated speed
+        double assumedSpeed = 2.0; // in m/s, the lowest speed used for ETA (team may start to move any time)
+        long minimalSleepTime = 5; // in seconds, shorter sleeps are not worth it
+        long wakeUpOverhead = 3; // in seconds, time needed to get a fresh fix after wake up
+        int fastSamplingRate = 500; // in ms, loop period when the waypoint is imminent
+        int slowSamplingRate = 2000; // in ms, loop period otherwise
+    };
+
+    struct report_config {
+        explicit report_config() = default;
+
+        report_config(float tolerance, float deadBand, long maxSilence) :
+                tolerance(tolerance),
+                deadBand(deadBand),
+                maxSilence(maxSilence) {}
+
+        static report_config build(JsonVariant &c) {
+            return {
+                    c["tolerance"] | 10.0f,
+                    c["dead-band"] | 5.0f,
+                    c["max-silence"] | 60L
+            };
+        }
+
+        float tolerance = 10; // in meters, max. distance of a suppressed position from the reported path
+        float deadBand = 5; // in meters, smaller movements are ignored
+        long maxSilence = 60; // in seconds, the longest time without a report (heartbeat)
+    };
+
+    struct motion_config {
+        explicit motion_config() = default;
+
+        motion_config(float stationarySpeed, float stationaryRadius, long stationaryTime, int minSatellites,
+                      int parkedSamplingRate, long parkedHeartbeat) :
+                stationarySpeed(stationarySpeed),
+                stationaryRadius(stationaryRadius),
+                stationaryTime(stationaryTime),
+                minSatellites(minSatellites),
+                parkedSamplingRate(parkedSamplingRate),
+                parkedHeartbeat(parkedHeartbeat) {}
+
+        static motion_config build(JsonVariant &c) {
+            return {
+                    c["stationary-speed"] | 0.5f,
+                    c["stationary-radius"] | 10.0f,
+                    c["stationary-time"] | 60L,
+                    c["min-satellites"] | 4,
+                    c["parked-sampling-rate"] | 20000,
+                    c["parked-heartbeat"] | 300L
+            };
+        }
+
+        float stationarySpeed = 0.5; // in m/s
+        float stationaryRadius = 10; // in meters
+        long stationaryTime = 60; // in seconds
+        int minSatellites = 4;
+        int parkedSamplingRate = 20000; // in ms, how often a parked tracker checks whether the heartbeat is due
+        long parkedHeartbeat = 300; // in seconds, the longest time without a report while parked
+    };
+
+    struct diagnostics_config {
+        explicit diagnostics_config() = default;
+
+        diagnostics_config(bool enable, std::string level, long budget, int batchSize, long batchAge) :
+                enable(enable),
+                level(std::move(level)),
+                budget(budget),
+                batchSize(batchSize),
+                batchAge(batchAge) {}
+
+        static diagnostics_config build(JsonVariant &c) {
+            return {
+                    c["enable"] | true,
+                    c["level"] | "warning",
+                    c["budget"] | 16384L,
+                    c["batch-size"] | 1024,
+                    c["batch-age"] | 600L
+            };
+        }
+
+        bool enable = true;
+        std::string level = "warning"; // the lowest level sent, can be changed by the server
+        long budget = 16384; // in bytes per hour
+        int batchSize = 1024; // in bytes, a batch is published when it is this big...
+        long batchAge = 600; // ...or when its oldest log is this old (in seconds)
+    };
+
+    struct audio_config {
+        explicit audio_config() = default;
+
+        audio_config(int readAhead, float prefetchDistance, bool keepPipeline) :
+                readAhead(readAhead),
+                prefetchDistance(prefetchDistance),
+                keepPipeline(keepPipeline) {}
+
+        static audio_config build(JsonVariant &c) {
+            return {
+                    c["read-ahead"] | 8192,
+                    c["prefetch-distance"] | 50.0f,
+                    c["keep-pipeline"] | false
+            };
+        }
+
+        int readAhead = 8192; // in bytes of the played file buffered in advance, used from the next boot
+        float prefetchDistance = 50; // in meters from the next waypoint, its sound is prepared from here on
+        bool keepPipeline = false; // the audio output and decoders are kept between sounds, used from the next boot
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_CONFIGURATIONSECTIONS_H
@@ -0,0 +1,145 @@
+#include "ConfigurationStore.h"
+#include <cmath>
+
+GPS_TRACKER::CONFIGURATION_UPDATE GPS_TRACKER::ConfigurationStore::load() {
+    std::lock_guard<std::mutex> lg(updateMutex);
+    auto candidate = std::make_shared<Configuration>();
+    if (!candidate->read()) {
+        return CONFIGURATION_NOT_READABLE;
+    }
+    return swap(candidate);
+}
+
+GPS_TRACKER::CONFIGURATION_UPDATE GPS_TRACKER::ConfigurationStore::reload() {
+    std::lock_guard<std::mutex> lg(updateMutex);
+    auto candidate = std::make_shared<Configuration>();
+    if (!candidate->readFile(CONFIG_PATH)) {
+        return CONFIGURATION_NOT_READABLE;
+    }
+    CONFIGURATION_UPDATE result = validate(*candidate);
+    if (result != CONFIGURATION_ACCEPTED) {
+        return result;
+    }
+    if (!overrideGamePack()) {
+        return CONFIGURATION_NOT_READABLE;
+    }
+    std::atomic_store(&actual, ConfigurationSnapshot(candidate));
+    return CONFIGURATION_ACCEPTED;
+}
+
+GPS_TRACKER::CONFIGURATION_UPDATE GPS_TRACKER::ConfigurationStore::update(const char *content, size_t length) {
+    std::lock_guard<std::mutex> lg(updateMutex);
+
+    // the loader streams from a file, so the content is parsed exactly like `config.json` on boot
+    File file = SPIFFS.open(CONFIG_UPDATE_PATH.c_str(), FILE_WRITE);
+    if (!file) {
+        return CONFIGURATION_NOT_READABLE;
+    }
+    bool written = file.write((const uint8_t *) content, length) == length;
+    file.close();
+
+    auto candidate = std::make_shared<Configuration>();
+    CONFIGURATION_UPDATE result = written && candidate->readFile(CONFIG_UPDATE_PATH) ? validate(*candidate)
+                                                                                      : CONFIGURATION_NOT_READABLE;
+    // the file must win over the game pack on the next boot, otherwise the update is lost by a reset
+    if (result == CONFIGURATION_ACCEPTED && (!replaceConfigFile() || !overrideGamePack())) {
+        result = CONFIGURATION_NOT_READABLE;
+    }
+    if (result != CONFIGURATION_ACCEPTED) {
+        SPIFFS.remove(CONFIG_UPDATE_PATH.c_str());
+        return result;
+    }
+    std::atomic_store(&actual, ConfigurationSnapshot(candidate));
+    return CONFIGURATION_ACCEPTED;
+}
+
+GPS_TRACKER::ConfigurationSnapshot GPS_TRACKER::ConfigurationStore::get() const {
+    return std::atomic_load(&actual);
+}
+
+const char *GPS_TRACKER::ConfigurationStore::toString(CONFIGURATION_UPDATE result) {
+    switch (result) {
+        case CONFIGURATION_ACCEPTED:
+            return "accepted";
+        case CONFIGURATION_NOT_READABLE:
+            return "not readable";
+        case CONFIGURATION_UNSUPPORTED_SCHEMA:
+            return "unsupported schema version";
+        case CONFIGURATION_FOREIGN_TRACKER:
+            return "tracker-id mismatch";
+        case CONFIGURATION_INVALID:
+            return "invalid values";
+        case CONFIGURATION_TOO_LARGE:
+            return "too large";
+    }
+    return "unknown";
+}
+
+GPS_TRACKER::CONFIGURATION_UPDATE GPS_TRACKER::ConfigurationStore::swap(
+        const std::shared_ptr<Configuration> &candidate) {
+    CONFIGURATION_UPDATE result = validate(*candidate);
+    if (result == CONFIGURATION_ACCEPTED) {
+        std::atomic_store(&actual, ConfigurationSnapshot(candidate));
+    }
+    return result;
+}
+
+GPS_TRACKER::CONFIGURATION_UPDATE GPS_TRACKER::ConfigurationStore::validate(const Configuration &candidate) const {
+    if (candidate.CONFIG.schemaVersion < 1 || candidate.CONFIG.schemaVersion > Configuration::SCHEMA_VERSION) {
+        return CONFIGURATION_UNSUPPORTED_SCHEMA;
+    }
+
+    // an update must not turn the tracker into another one (the id is the identity of the team)
+    ConfigurationSnapshot current = get();
+    if (current != nullptr && candidate.CONFIG.trackerId != current->CONFIG.trackerId) {
+        return CONFIGURATION_FOREIGN_TRACKER;
+    }
+
+    const config &general = candidate.CONFIG;
+    if (general.trackerId < 0 || general.accuracy <= 0 || general.sleepTime < 0) {
+        return CONFIGURATION_INVALID;
+    }
+    if (candidate.GSM_CONFIG.enable && candidate.MQTT_CONFIG.host.empty()) {
+        return CONFIGURATION_INVALID;
+    }
+    if (candidate.GPS_CONFIG.uere <= 0 || candidate.GPS_CONFIG.outlierGate <= 0) {
+        return CONFIGURATION_INVALID;
+    }
+    const sleep_config &sleep = candidate.SLEEP_CONFIG;
+    if (sleep.fastSamplingRate <= 0 || sleep.slowSamplingRate < sleep.fastSamplingRate ||
+        candidate.MOTION_CONFIG.parkedSamplingRate <= 0) {
+        return CONFIGURATION_INVALID;
+    }
+    const diagnostics_config &diagnostics = candidate.DIAGNOSTICS_CONFIG;
+    if (diagnostics.budget < 0 || diagnostics.batchSize <= 0 || diagnostics.batchAge < 0) {
+        return CONFIGURATION_INVALID;
+    }
+    if (candidate.AUDIO_CONFIG.readAhead < 0 || candidate.AUDIO_CONFIG.prefetchDistance < 0) {
+        return CONFIGURATION_INVALID;
+    }
+    for (size_t i = 0; i < candidate.WAYPOINTS.size(); i++) {
+        if (fabsf(candidate.WAYPOINTS.lat(i)) > 90 || fabsf(candidate.WAYPOINTS.lon(i)) > 180) {
+            return CONFIGURATION_INVALID;
+        }
+    }
+    return CONFIGURATION_ACCEPTED;
+}
+
+bool GPS_TRACKER::ConfigurationStore::overrideGamePack() const {
+    ConfigurationSnapshot current = get();
+    return current == nullptr || current->overrideGamePack();
+}
+
+bool GPS_TRACKER::ConfigurationStore::replaceConfigFile() {
+    // SPIFFS cannot rename over an existing file; the backup is read on boot if a reset comes in between
+    SPIFFS.remove(CONFIG_BACKUP_PATH.c_str());
+    if (SPIFFS.exists(CONFIG_PATH.c_str()) && !SPIFFS.rename(CONFIG_PATH.c_str(), CONFIG_BACKUP_PATH.c_str())) {
+        return false;
+    }
+    if (!SPIFFS.rename(CONFIG_UPDATE_PATH.c_str(), CONFIG_PATH.c_str())) {
+        SPIFFS.rename(CONFIG_BACKUP_PATH.c_str(), CONFIG_PATH.c_str());
+        return false;
+    }
+    SPIFFS.remove(CONFIG_BACKUP_PATH.c_str());
+    return true;
+}
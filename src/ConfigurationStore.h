@@ -0,0 +1,72 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_CONFIGURATIONSTORE_H
+#define LIGHTWEIGHT_GPS_TRACKER_CONFIGURATIONSTORE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include "Configuration.h"
+
+namespace GPS_TRACKER {
+    /**
+     * Immutable configuration shared by all subsystems. Holding the pointer keeps the snapshot alive even when
+     * a newer one was swapped in meanwhile.
+     * */
+    typedef std::shared_ptr<const Configuration> ConfigurationSnapshot;
+
+    enum CONFIGURATION_UPDATE {
+        CONFIGURATION_ACCEPTED,
+        CONFIGURATION_NOT_READABLE, // the file cannot be stored or parsed
+        CONFIGURATION_UNSUPPORTED_SCHEMA, // written for a newer firmware
+        CONFIGURATION_FOREIGN_TRACKER, // `tracker-id` does not match the running tracker
+        CONFIGURATION_INVALID, // values out of range
+        CONFIGURATION_TOO_LARGE // the downlinked file did not fit the MQTT read buffer
+    };
+
+    /**
+     * Owner of the actual configuration.
+     *
+     * Subsystems never copy the configuration, they take the actual snapshot by `get()` whenever they need it
+     * (it is cheap and safe from any task). New configurations are fully loaded and validated aside and then
+     * swapped in atomically, so nobody ever sees a half-applied update and a rejected update changes nothing.
+     * */
+    class ConfigurationStore {
+    public:
+        /**
+         * Loads the initial configuration (game pack or `config.json`).
+         * */
+        CONFIGURATION_UPDATE load();
+
+        /**
+         * Loads `config.json` again, e.g. after it was uploaded. An accepted file supersedes the game pack from now on.
+         * */
+        CONFIGURATION_UPDATE reload();
+
+        /**
+         * Replaces the configuration by the content of a whole `config.json` (e.g. received by MQTT).
+         * The accepted content is persisted, the file is replaced in a way which survives a reset at any moment
+         * and supersedes the game pack on the next boots.
+         * */
+        CONFIGURATION_UPDATE update(const char *content, size_t length);
+
+        [[nodiscard]] ConfigurationSnapshot get() const;
+
+        static const char *toString(CONFIGURATION_UPDATE result);
+
+    private:
+        CONFIGURATION_UPDATE swap(const std::shared_ptr<Configuration> &candidate);
+
+        [[nodiscard]] CONFIGURATION_UPDATE validate(const Configuration &candidate) const;
+
+        /**
+         * Makes `config.json` win over the game pack in use on the next boot.
+         * */
+        [[nodiscard]] bool overrideGamePack() const;
+
+        static bool replaceConfigFile();
+
+        ConfigurationSnapshot actual; // accessed only by std::atomic_load/std::atomic_store
+        std::mutex updateMutex; // updates share the temporary file
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_CONFIGURATIONSTORE_H
@@ -26,6 +26,9 @@ static const std::string  PASSWORD = "tracker123";
 
 #define uS_TO_S_FACTOR 1000000
 static const std::string CONFIG_PATH = "/config.json";
+static const std::string CONFIG_UPDATE_PATH = "/config.new.json"; // downlinked configuration being validated
+static const std::string CONFIG_BACKUP_PATH = "/config.old.json"; // previous configuration while it is replaced
+static const std::string CONFIG_OVERRIDE_PATH = "/config.pack"; // CRC of the game pack `config.json` supersedes
 static const int DEFAULT_VOLUME = 100; // %
 
 static const std::string SERVER_NAME = "";
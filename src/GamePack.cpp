@@ -0,0 +1,114 @@
+#include "GamePack.h"
+#include <cstring>
+#include <rom/crc.h>
+
+GPS_TRACKER::GamePack::~GamePack() {
+    unmap();
+}
+
+bool GPS_TRACKER::GamePack::map() {
+    unmap();
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, PARTITION_SUBTYPE,
+                                                                "gamepack");
+    if (partition == nullptr) {
+        return false;
+    }
+
+    const void *ptr;
+    if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &ptr, &handle) != ESP_OK) {
+        return false;
+    }
+    base = static_cast<const uint8_t *>(ptr);
+
+    if (!validate(partition->size)) {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void GPS_TRACKER::GamePack::unmap() {
+    if (base != nullptr) {
+        spi_flash_munmap(handle);
+        base = nullptr;
+    }
+}
+
+bool GPS_TRACKER::GamePack::isMapped() const {
+    return base != nullptr;
+}
+
+bool GPS_TRACKER::GamePack::validate(size_t partitionSize) const {
+    const GamePackHeader &h = header();
+    if (memcmp(h.magic, "GPAK", 4) != 0 || h.version != VERSION || h.headerSize != sizeof(GamePackHeader)) {
+        return false;
+    }
+    if (h.totalSize < h.headerSize || h.totalSize > partitionSize ||
+        h.waypointsCount > h.totalSize || h.pathsCount > h.totalSize) {
+        return false;
+    }
+
+    bool sectionsFit = sectionFits(h.settingsOffset, h.settingsSize) &&
+                       sectionFits(h.latsOffset, h.waypointsCount * sizeof(int32_t)) &&
+                       sectionFits(h.lonsOffset, h.waypointsCount * sizeof(int32_t)) &&
+                       sectionFits(h.idsOffset, h.waypointsCount * sizeof(uint16_t)) &&
+                       sectionFits(h.pathIndexesOffset, h.waypointsCount * sizeof(uint16_t)) &&
+                       sectionFits(h.pathOffsetsOffset, h.pathsCount * sizeof(uint16_t)) &&
+                       sectionFits(h.pathDataOffset, h.pathDataSize);
+    if (!sectionsFit || h.latsOffset % 4 != 0 || h.lonsOffset % 4 != 0) {
+        return false;
+    }
+
+    if (crc32_le(0, base + h.headerSize, h.totalSize - h.headerSize) != h.crc) {
+        return false;
+    }
+
+    // references between sections (CRC says the data are not corrupted, not that the tool was correct)
+    if (h.pathDataSize == 0 ? h.pathsCount > 0 : pathData()[h.pathDataSize - 1] != '\0') {
+        return false;
+    }
+    for (uint32_t i = 0; i < h.pathsCount; i++) {
+        if (pathOffsets()[i] >= h.pathDataSize) return false;
+    }
+    for (uint32_t i = 0; i < h.waypointsCount; i++) {
+        if (pathIndexes()[i] >= h.pathsCount) return false;
+    }
+    return true;
+}
+
+bool GPS_TRACKER::GamePack::sectionFits(uint32_t offset, uint32_t size) const {
+    const GamePackHeader &h = header();
+    return offset >= h.headerSize && offset <= h.totalSize && size <= h.totalSize - offset;
+}
+
+const GPS_TRACKER::GamePackHeader &GPS_TRACKER::GamePack::header() const {
+    return *at<GamePackHeader>(0);
+}
+
+const char *GPS_TRACKER::GamePack::settings() const {
+    return at<char>(header().settingsOffset);
+}
+
+const int32_t *GPS_TRACKER::GamePack::lats() const {
+    return at<int32_t>(header().latsOffset);
+}
+
+const int32_t *GPS_TRACKER::GamePack::lons() const {
+    return at<int32_t>(header().lonsOffset);
+}
+
+const uint16_t *GPS_TRACKER::GamePack::ids() const {
+    return at<uint16_t>(header().idsOffset);
+}
+
+const uint16_t *GPS_TRACKER::GamePack::pathIndexes() const {
+    return at<uint16_t>(header().pathIndexesOffset);
+}
+
+const uint16_t *GPS_TRACKER::GamePack::pathOffsets() const {
+    return at<uint16_t>(header().pathOffsetsOffset);
+}
+
+const char *GPS_TRACKER::GamePack::pathData() const {
+    return at<char>(header().pathDataOffset);
+}
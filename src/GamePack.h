@@ -0,0 +1,87 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_GAMEPACK_H
+#define LIGHTWEIGHT_GPS_TRACKER_GAMEPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <esp_partition.h>
+
+namespace GPS_TRACKER {
+    /**
+     * Header of the binary game pack, see `tools/gamepack.py` for the layout. All offsets are from the start
+     * of the pack.
+     * */
+    struct GamePackHeader {
+        char magic[4];
+        uint16_t version;
+        uint16_t headerSize;
+        uint32_t totalSize;
+        uint32_t crc;
+        uint32_t settingsOffset;
+        uint32_t settingsSize;
+        uint32_t waypointsCount;
+        uint32_t latsOffset;
+        uint32_t lonsOffset;
+        uint32_t idsOffset;
+        uint32_t pathIndexesOffset;
+        uint32_t pathsCount;
+        uint32_t pathOffsetsOffset;
+        uint32_t pathDataOffset;
+        uint32_t pathDataSize;
+    };
+
+    static_assert(sizeof(GamePackHeader) == 60, "GamePackHeader must match tools/gamepack.py");
+
+    /**
+     * Precompiled game configuration memory mapped from the `gamepack` partition. Data are read in place,
+     * nothing is copied to RAM.
+     * */
+    class GamePack {
+    public:
+        static constexpr uint16_t VERSION = 1;
+        static constexpr esp_partition_subtype_t PARTITION_SUBTYPE = (esp_partition_subtype_t) 0x40;
+
+        ~GamePack();
+
+        /**
+         * Maps the partition and validates the pack (magic, version, bounds of all sections and CRC).
+         *
+         * @return false if there is no valid pack
+         * */
+        bool map();
+
+        void unmap();
+
+        [[nodiscard]] bool isMapped() const;
+
+        [[nodiscard]] const GamePackHeader &header() const;
+
+        [[nodiscard]] const char *settings() const;
+
+        [[nodiscard]] const int32_t *lats() const;
+
+        [[nodiscard]] const int32_t *lons() const;
+
+        [[nodiscard]] const uint16_t *ids() const;
+
+        [[nodiscard]] const uint16_t *pathIndexes() const;
+
+        [[nodiscard]] const uint16_t *pathOffsets() const;
+
+        [[nodiscard]] const char *pathData() const;
+
+    private:
+        [[nodiscard]] bool validate(size_t partitionSize) const;
+
+        [[nodiscard]] bool sectionFits(uint32_t offset, uint32_t size) const;
+
+        template<typename T>
+        const T *at(uint32_t offset) const {
+            return reinterpret_cast<const T *>(base + offset);
+        }
+
+        const uint8_t *base = nullptr;
+        spi_flash_mmap_handle_t handle = 0;
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_GAMEPACK_H
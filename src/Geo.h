@@ -0,0 +1,30 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_GEO_H
+#define LIGHTWEIGHT_GPS_TRACKER_GEO_H
+
+#include <cmath>
+
+namespace GPS_TRACKER {
+    namespace Geo {
+        static constexpr double EARTH_RADIUS = 6378388; // in meters
+
+        inline double deg2rad(double deg) {
+            return (deg * M_PI / 180);
+        }
+
+        /**
+         * Great-circle distance between two positions (spherical law of cosines).
+         *
+         * @return distance in meters
+         * */
+        inline double distance(double lat1, double lon1, double lat2, double lon2) {
+            double cosAngle = sin(deg2rad(lat1)) * sin(deg2rad(lat2)) +
+                              cos(deg2rad(lat1)) * cos(deg2rad(lat2)) * cos(deg2rad(lon2 - lon1));
+            // rounding errors may push the value slightly out of acos domain for (almost) identical points
+            if (cosAngle > 1) cosAngle = 1;
+            if (cosAngle < -1) cosAngle = -1;
+            return EARTH_RADIUS * acos(cosAngle);
+        }
+    }
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_GEO_H
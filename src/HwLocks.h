@@ -2,10 +2,28 @@
 #define LIGHTWEIGHT_GPS_TRACKER_HWLOCKS_H
 
 #include <mutex>
+#include "PowerManager.h"
 
 class HwLocks {
 public:
     static std::recursive_mutex SERIAL_LOCK;
 };
 
+/**
+ * Exclusive access to the modem. Holds `SERIAL_LOCK` and keeps the chip out of light sleep (the UART would lose
+ * the modem's responses), so it must not be held while waiting for something else than the modem.
+ * */
+class SerialGuard {
+public:
+    SerialGuard() : lock(HwLocks::SERIAL_LOCK), power(GPS_TRACKER::PowerManager::MODEM) {}
+
+    SerialGuard(const SerialGuard &) = delete;
+
+    SerialGuard &operator=(const SerialGuard &) = delete;
+
+private:
+    std::lock_guard<std::recursive_mutex> lock;
+    GPS_TRACKER::PowerLock::Guard power;
+};
+
 #endif //LIGHTWEIGHT_GPS_TRACKER_HWLOCKS_H
@@ -2,6 +2,7 @@
 #include "Constants.h"
 #include <WiFi.h>
 #include <AsyncElegantOTA.h>
+#include <memory>
 
 void OtaUpdater::init() {
     WiFi.mode(WIFI_MODE_AP);
@@ -9,6 +10,18 @@ void OtaUpdater::init() {
     server.on("/status", HTTP_GET, [](AsyncWebServerRequest *request) {
         request->send(200, "text/json", R"({"status": "OK"})");
     });
+    if (flightRecorder.open()) {
+        // binary frames, decode by `python tools/logdecoder.py firmware.elf flightrec.bin`
+        server.on("/logs", HTTP_GET, [this](AsyncWebServerRequest *request) {
+            auto cursor = std::make_shared<Logging::FlightRecorder::Cursor>(flightRecorder.begin());
+            AsyncWebServerResponse *response = request->beginChunkedResponse(
+                    "application/octet-stream", [this, cursor](uint8_t *buffer, size_t maxLength, size_t index) {
+                        return flightRecorder.read(*cursor, buffer, maxLength);
+                    });
+            response->addHeader("Content-Disposition", "attachment; filename=flightrec.bin");
+            request->send(response);
+        });
+    }
 }
 
 void OtaUpdater::begin() {
@@ -4,6 +4,7 @@
 #include <WiFi.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
+#include "logger/FlightRecorder.h"
 
 class OtaUpdater {
 public:
@@ -15,6 +16,7 @@ public:
 
 private:
     AsyncWebServer server = AsyncWebServer(80);
+    Logging::FlightRecorder flightRecorder;
 };
 
 
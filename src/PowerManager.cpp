@@ -0,0 +1,46 @@
+#include "PowerManager.h"
+#include <sdkconfig.h>
+
+#if CONFIG_PM_ENABLE
+#include <esp32/pm.h>
+#endif
+
+GPS_TRACKER::PowerLock::PowerLock(const char *name, esp_pm_lock_type_t type) : name(name), type(type) {}
+
+void GPS_TRACKER::PowerLock::acquire() {
+#if CONFIG_PM_ENABLE
+    // created lazily, static locks are constructed before the SDK is ready
+    std::call_once(created, [this] { esp_pm_lock_create(type, 0, name, &handle); });
+    if (handle != nullptr) esp_pm_lock_acquire(handle);
+#endif
+}
+
+void GPS_TRACKER::PowerLock::release() {
+#if CONFIG_PM_ENABLE
+    if (handle != nullptr) esp_pm_lock_release(handle);
+#endif
+}
+
+bool GPS_TRACKER::PowerManager::begin() {
+#if CONFIG_PM_ENABLE
+    esp_pm_config_esp32_t config = {};
+    config.max_freq_mhz = MAX_FREQUENCY;
+    config.min_freq_mhz = MIN_FREQUENCY;
+#ifdef CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    config.light_sleep_enable = true;
+#endif
+    if (esp_pm_configure(&config) == ESP_OK) {
+        automaticSleep = config.light_sleep_enable;
+    }
+#endif
+    return automaticSleep;
+}
+
+bool GPS_TRACKER::PowerManager::isAutomaticSleep() {
+    return automaticSleep;
+}
+
+bool GPS_TRACKER::PowerManager::automaticSleep = false;
+GPS_TRACKER::PowerLock GPS_TRACKER::PowerManager::AUDIO("audio", ESP_PM_CPU_FREQ_MAX);
+GPS_TRACKER::PowerLock GPS_TRACKER::PowerManager::TLS("tls", ESP_PM_CPU_FREQ_MAX);
+GPS_TRACKER::PowerLock GPS_TRACKER::PowerManager::MODEM("modem", ESP_PM_NO_LIGHT_SLEEP);
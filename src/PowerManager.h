@@ -0,0 +1,72 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_POWERMANAGER_H
+#define LIGHTWEIGHT_GPS_TRACKER_POWERMANAGER_H
+
+#include <esp_pm.h>
+#include <mutex>
+
+namespace GPS_TRACKER {
+    /**
+     * Power management lock of a subsystem. While any lock is held the chip stays awake (at full clock for
+     * `ESP_PM_CPU_FREQ_MAX`), when all of them are released it scales the clock down and, with tickless idle,
+     * enters light sleep on its own whenever all tasks are blocked.
+     *
+     * Acquisitions are counted, every `acquire()` needs its `release()`. Without power management support
+     * in the SDK the locks do nothing.
+     * */
+    class PowerLock {
+    public:
+        PowerLock(const char *name, esp_pm_lock_type_t type);
+
+        void acquire();
+
+        void release();
+
+        class Guard {
+        public:
+            explicit Guard(PowerLock &lock) : lock(lock) {
+                lock.acquire();
+            }
+
+            ~Guard() {
+                lock.release();
+            }
+
+            Guard(const Guard &) = delete;
+
+            Guard &operator=(const Guard &) = delete;
+
+        private:
+            PowerLock &lock;
+        };
+
+    private:
+        const char *name;
+        esp_pm_lock_type_t type;
+        esp_pm_lock_handle_t handle = nullptr;
+        std::once_flag created;
+    };
+
+    class PowerManager {
+    public:
+        static constexpr int MAX_FREQUENCY = 240; // MHz
+        static constexpr int MIN_FREQUENCY = 80; // MHz, APB (UART, I2S) keeps its clock down to 80 MHz
+
+        /**
+         * Enables dynamic frequency scaling and automatic light sleep if the SDK supports them.
+         *
+         * @return true if the chip sleeps on its own, otherwise the tracker has to call `esp_light_sleep_start()`
+         * */
+        static bool begin();
+
+        static bool isAutomaticSleep();
+
+        static PowerLock AUDIO; // decoding and I2S output
+        static PowerLock TLS; // encryption of the MQTT connection
+        static PowerLock MODEM; // modem UART exchanges and the MQTT session, received bytes are lost in light sleep
+
+    private:
+        static bool automaticSleep;
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_POWERMANAGER_H
@@ -1,8 +1,11 @@
 #ifndef LIGHTWEIGHT_GPS_TRACKER_PROTOCOL_H
 #define LIGHTWEIGHT_GPS_TRACKER_PROTOCOL_H
 
+#include <string>
 #include <utility>
+#ifdef ESP_PLATFORM
 #include "Arduino.h"
+#endif
 #include "ArduinoJson.h"
 
 namespace GPS_TRACKER {
@@ -17,9 +20,9 @@ namespace GPS_TRACKER {
     struct GPSCoordinates : Serializable {
         GPSCoordinates() {};
 
-        GPSCoordinates(float lat, float lon, float alt, long timestamp) :
+        GPSCoordinates(float lat, float lon, float alt, long timestamp, float speed = 0, int satellites = 0) :
                 lat(lat), lon(lon), alt(alt),
-                timestamp(timestamp) {}
+                timestamp(timestamp), speed(speed), satellites(satellites) {}
 
         [[nodiscard]] JsonVariant toJson() const override {
             DynamicJsonDocument doc(1024);
@@ -41,6 +44,8 @@ namespace GPS_TRACKER {
         float lon;
         float alt;
         long timestamp;
+        float speed = 0; // speed over ground in m/s
+        int satellites = 0; // satellites used for the fix
     };
 
     struct Message : Serializable {
@@ -0,0 +1,76 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_SEQLOCK_H
+#define LIGHTWEIGHT_GPS_TRACKER_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+/**
+ * Sequence lock. Readers get a consistent copy of the value without taking any lock, they just retry when a write
+ * happened meanwhile. Writers are serialized by a mutex and publish the new value as a whole.
+ *
+ * A reader which keeps meeting a write (e.g. the writer was preempted by the reader on the same core) falls back to
+ * the writer mutex. Spinning would never let the writer run, the mutex lends it the priority of the reader.
+ *
+ * Intended for small, trivially copyable values which are read much more often than written.
+ * */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock value must be trivially copyable");
+
+public:
+    SeqLock() = default;
+
+    explicit SeqLock(const T &initial) : value(initial) {}
+
+    [[nodiscard]] T read() const {
+        T copy;
+        for (int attempt = 0; attempt < OPTIMISTIC_READS; attempt++) {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1U) {
+                // writer is in the middle of publishing
+                continue;
+            }
+            std::memcpy(&copy, &value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return copy;
+            }
+        }
+        std::lock_guard<std::mutex> lock(writeMutex);
+        std::memcpy(&copy, &value, sizeof(T));
+        return copy;
+    }
+
+    /**
+     * Applies `update` to a private copy of the value and publishes the result.
+     * */
+    template<typename F>
+    void write(F &&update) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        T next;
+        std::memcpy(&next, &value, sizeof(T));
+        update(next);
+
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&value, &next, sizeof(T));
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    void store(const T &newValue) {
+        write([&newValue](T &v) { v = newValue; });
+    }
+
+private:
+    static constexpr int OPTIMISTIC_READS = 4; // then the reader waits for the writer on its mutex
+
+    std::atomic<uint32_t> sequence{0};
+    mutable std::mutex writeMutex;
+    T value{};
+};
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_SEQLOCK_H
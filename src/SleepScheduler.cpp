@@ -0,0 +1,59 @@
+#include "SleepScheduler.h"
+#include <algorithm>
+#include "Geo.h"
+
+void GPS_TRACKER::SleepScheduler::addFix(const GPSCoordinates &fix) {
+    history[historyHead] = fix;
+    historyHead = (historyHead + 1) % HISTORY_SIZE;
+    if (historyLength < HISTORY_SIZE) historyLength++;
+}
+
+GPS_TRACKER::SleepScheduler::Plan GPS_TRACKER::SleepScheduler::plan(const config &generalConfig,
+                                                                    const sleep_config &sleepConfig,
+                                                                    double distance) const {
+    Plan plan{};
+    plan.speed = estimatedSpeed(sleepConfig);
+    double remaining = distance - generalConfig.accuracy;
+    plan.eta = remaining <= 0 ? 0 : remaining / plan.speed;
+
+    double available = plan.eta - (double) sleepConfig.wakeUpOverhead;
+    if (available < (double) sleepConfig.minimalSleepTime) {
+        plan.sleepTime = 0;
+    } else if (available > (double) generalConfig.sleepTime) {
+        plan.sleepTime = generalConfig.sleepTime;
+    } else {
+        plan.sleepTime = (long) available;
+    }
+
+    // several samples before the team may reach the waypoint and at least two while it crosses the waypoint area
+    double period = std::min(plan.eta / 4, generalConfig.accuracy / plan.speed) * 1000;
+    if (period < sleepConfig.fastSamplingRate) {
+        plan.samplingRate = sleepConfig.fastSamplingRate;
+    } else if (period > sleepConfig.slowSamplingRate) {
+        plan.samplingRate = sleepConfig.slowSamplingRate;
+    } else {
+        plan.samplingRate = (int) period;
+    }
+    return plan;
+}
+
+double GPS_TRACKER::SleepScheduler::estimatedSpeed(const sleep_config &sleepConfig) const {
+    double speed = 0;
+    if (historyLength > 0) {
+        const GPSCoordinates &newest = history[(historyHead + HISTORY_SIZE - 1) % HISTORY_SIZE];
+        const GPSCoordinates &oldest = history[(historyHead + HISTORY_SIZE - historyLength) % HISTORY_SIZE];
+
+        // the highest reported speed, short bursts (running team) must not be averaged out
+        for (size_t i = 0; i < historyLength; i++) {
+            speed = std::max(speed, (double) history[i].speed);
+        }
+
+        // speed derived from the displacement covers fixes without valid speed
+        long elapsed = newest.timestamp - oldest.timestamp;
+        if (elapsed > 0) {
+            double displacement = Geo::distance(oldest.lat, oldest.lon, newest.lat, newest.lon);
+            speed = std::max(speed, displacement / (double) elapsed);
+        }
+    }
+    return std::max(speed * sleepConfig.safetyMargin, sleepConfig.assumedSpeed);
+}
@@ -0,0 +1,46 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_SLEEPSCHEDULER_H
+#define LIGHTWEIGHT_GPS_TRACKER_SLEEPSCHEDULER_H
+
+#include <array>
+#include "ConfigurationSections.h"
+#include "Protocol.h"
+
+namespace GPS_TRACKER {
+    /**
+     * Chooses how long the tracker may sleep and how often it should sample the position.
+     *
+     * The decision is based on ETA to the next waypoint. ETA is estimated from the distance and from the speed of
+     * recent fixes (multiplied by the safety margin). The team may start to move any time, therefore the speed is
+     * never considered lower than `assumed-speed`.
+     *
+     * Parameters come with every call from the configuration snapshot of the caller, so reloaded values apply with
+     * the next decision and a single decision never mixes two configurations.
+     * */
+    class SleepScheduler {
+    public:
+        struct Plan {
+            double speed; // used for the ETA estimation in m/s (safety margin included)
+            double eta; // the shortest time (in seconds) in which the team could reach the waypoint
+            long sleepTime; // how long the tracker may sleep in seconds, 0 if it should stay awake
+            int samplingRate; // period of the tracker loop in ms
+        };
+
+        void addFix(const GPSCoordinates &fix);
+
+        /**
+         * @param distance distance to the next waypoint in meters
+         * */
+        [[nodiscard]] Plan plan(const config &generalConfig, const sleep_config &sleepConfig, double distance) const;
+
+    private:
+        static constexpr size_t HISTORY_SIZE = 5;
+
+        [[nodiscard]] double estimatedSpeed(const sleep_config &sleepConfig) const;
+
+        std::array<GPSCoordinates, HISTORY_SIZE> history;
+        size_t historyLength = 0;
+        size_t historyHead = 0;
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_SLEEPSCHEDULER_H
@@ -1,7 +1,8 @@
 #include "StateManager.h"
+#include "Geo.h"
 
-GPS_TRACKER::StateManager::StateManager(GPS_TRACKER::Configuration *configuration) :
-        configuration(configuration) {}
+GPS_TRACKER::StateManager::StateManager(GPS_TRACKER::ConfigurationStore *configurations) :
+        configurations(configurations) {}
 
 void GPS_TRACKER::StateManager::begin() {
     loadPersistState();
@@ -18,7 +19,7 @@ void GPS_TRACKER::StateManager::loadPersistState() {
         return;
     }
     deserialize(doc);
-    Serial.printf("Visited waypoints %d\n", visitedWaypoints);
+    Serial.printf("Visited waypoints %d\n", getVisitedWaypoints());
     file.close();
 }
 
@@ -27,12 +28,13 @@ void GPS_TRACKER::StateManager::clearMemory() {
 }
 
 void GPS_TRACKER::StateManager::serialize(JsonDocument *doc) const {
-    (*doc)["visited-waypoints"] = visitedWaypoints;
+    (*doc)["visited-waypoints"] = getVisitedWaypoints();
     (*doc)["last-fast-fix-file-update"] = lastFastFixFileUpdate;
 }
 
 void GPS_TRACKER::StateManager::deserialize(JsonDocument &doc) {
-    visitedWaypoints = doc["visited-waypoints"];
+    size_t visited = doc["visited-waypoints"];
+    state.write([visited](TrackerState &s) { s.visitedWaypoints = visited; });
     lastFastFixFileUpdate = doc["last-fast-fix-file-update"];
 }
 
@@ -48,62 +50,62 @@ void GPS_TRACKER::StateManager::persistState() {
 }
 
 MQTT::STATE GPS_TRACKER::StateManager::getMqttState() const {
-    return mqttState;
+    return state.read().mqttState;
 }
 
 GSM::STATE GPS_TRACKER::StateManager::getGsmState() const {
-    return gsmState;
+    return state.read().gsmState;
 }
 
-void GPS_TRACKER::StateManager::setMqttState(MQTT::STATE state) {
-    StateManager::mqttState = state;
+void GPS_TRACKER::StateManager::setMqttState(MQTT::STATE mqttState) {
+    state.write([mqttState](TrackerState &s) { s.mqttState = mqttState; });
 }
 
-void GPS_TRACKER::StateManager::setGsmState(GSM::STATE state) {
-    StateManager::gsmState = state;
+void GPS_TRACKER::StateManager::setGsmState(GSM::STATE gsmState) {
+    state.write([gsmState](TrackerState &s) { s.gsmState = gsmState; });
 }
 
 size_t GPS_TRACKER::StateManager::getVisitedWaypoints() const {
-    return visitedWaypoints;
+    return state.read().visitedWaypoints;
+}
+
+GPS_TRACKER::TrackerState GPS_TRACKER::StateManager::snapshot() const {
+    return state.read();
 }
 
 void GPS_TRACKER::StateManager::checkCollision() {
+    size_t visitedWaypoints = getVisitedWaypoints();
+    ConfigurationSnapshot configuration = configurations->get(); // keeps the path valid during the callback
     if (visitedWaypoints < configuration->WAYPOINTS.size()) {
         // waypoint reached
         if (distanceToNextWaypoint() <= configuration->CONFIG.accuracy) {
             newWaypointReachedCallback(configuration->WAYPOINTS[visitedWaypoints]);
-            visitedWaypoints++;
+            state.write([](TrackerState &s) { s.visitedWaypoints++; });
             persistState();
         }
     }
 }
 
 double GPS_TRACKER::StateManager::distanceToNextWaypoint() {
-    if(visitedWaypoints == configuration->WAYPOINTS.size()){
+    TrackerState actState = state.read();
+    ConfigurationSnapshot configuration = configurations->get();
+    if (actState.visitedWaypoints >= configuration->WAYPOINTS.size()) {
         return std::numeric_limits<double>::max();
     }
-    auto distanceFromNextWaypointInKm =
-            6378.388 *
-            acos(sin(deg2rad(actPosition.lat)) * sin(deg2rad(configuration->WAYPOINTS[visitedWaypoints].lat)) +
-                 cos(deg2rad(actPosition.lat)) * cos(
-                         deg2rad(configuration->WAYPOINTS[visitedWaypoints].lat)) *
-                 cos(deg2rad(configuration->WAYPOINTS[visitedWaypoints].lon - actPosition.lon)));
-    double distanceFromNextWaypoint = distanceFromNextWaypointInKm * 1000;
-    Serial.printf("Distance from next waypoint %f, %f is %f\n", configuration->WAYPOINTS[visitedWaypoints].lat,
-                  configuration->WAYPOINTS[visitedWaypoints].lon, distanceFromNextWaypoint);
+    float nextLat = configuration->WAYPOINTS.lat(actState.visitedWaypoints);
+    float nextLon = configuration->WAYPOINTS.lon(actState.visitedWaypoints);
+    double distanceFromNextWaypoint = Geo::distance(actState.lat, actState.lon, nextLat, nextLon);
+    Serial.printf("Distance from next waypoint %f, %f is %f\n", nextLat, nextLon, distanceFromNextWaypoint);
     return distanceFromNextWaypoint;
 }
 
-double GPS_TRACKER::StateManager::deg2rad(float deg) {
-    return (deg * M_PI / 180);
-}
-
 void GPS_TRACKER::StateManager::onReachedWaypoint(std::function<void(const waypoint &)> callback) {
     newWaypointReachedCallback = std::move(callback);
 }
 
 void GPS_TRACKER::StateManager::test() {
-    newWaypointReachedCallback(configuration->WAYPOINTS[visitedWaypoints]);
+    ConfigurationSnapshot configuration = configurations->get();
+    newWaypointReachedCallback(configuration->WAYPOINTS[getVisitedWaypoints()]);
 }
 
 void GPS_TRACKER::StateManager::removePersistedState() {
@@ -111,10 +113,21 @@ void GPS_TRACKER::StateManager::removePersistedState() {
 }
 
 void GPS_TRACKER::StateManager::updatePosition(GPS_TRACKER::GPSCoordinates newPosition) {
-    actPosition = std::move(newPosition);
+    state.write([&newPosition](TrackerState &s) {
+        s.lat = newPosition.lat;
+        s.lon = newPosition.lon;
+        s.alt = newPosition.alt;
+        s.timestamp = newPosition.timestamp;
+        s.speed = newPosition.speed;
+        s.satellites = newPosition.satellites;
+    });
     checkCollision();
 }
 
+GPS_TRACKER::GPSCoordinates GPS_TRACKER::StateManager::getActPosition() const {
+    return state.read().position();
+}
+
 GPS_TRACKER::Timestamp GPS_TRACKER::StateManager::getLastFastFixFileUpdate() const {
     return lastFastFixFileUpdate;
 }
@@ -129,9 +142,9 @@ esp_sleep_wakeup_cause_t GPS_TRACKER::StateManager::getWakeupReason() const {
 }
 
 void GPS_TRACKER::StateManager::setNumberOfConnectedDevices(uint8_t no) {
-    connectedDevices = no;
+    state.write([no](TrackerState &s) { s.connectedDevices = no; });
 }
 
 bool GPS_TRACKER::StateManager::couldSleep() {
-    return connectedDevices == 0;
+    return state.read().connectedDevices == 0;
 }
@@ -8,7 +8,8 @@
 #include <utility>
 #include <functional>
 #include "Protocol.h"
-#include "Configuration.h"
+#include "ConfigurationStore.h"
+#include "SeqLock.h"
 
 namespace MQTT {
     enum STATE {
@@ -28,9 +29,29 @@ namespace AudioPlayer {
 }
 
 namespace GPS_TRACKER {
+    /**
+     * State shared between tasks. It is published as a whole, so readers always see a consistent view.
+     * */
+    struct TrackerState {
+        [[nodiscard]] GPSCoordinates position() const {
+            return {lat, lon, alt, timestamp, speed, satellites};
+        }
+
+        float lat = 0;
+        float lon = 0;
+        float alt = 0;
+        long timestamp = 0;
+        float speed = 0;
+        int satellites = 0;
+        size_t visitedWaypoints = 0;
+        MQTT::STATE mqttState = MQTT::DISCONNECTED;
+        GSM::STATE gsmState = GSM::DISCONNECTED;
+        uint8_t connectedDevices = 0;
+    };
+
     class StateManager {
     public:
-        explicit StateManager(Configuration *configuration);
+        explicit StateManager(ConfigurationStore *configurations);
 
         /**
          * Call after the SPIFFS is initialized.
@@ -53,6 +74,13 @@ namespace GPS_TRACKER {
 
         void updatePosition(GPS_TRACKER::GPSCoordinates newPosition);
 
+        [[nodiscard]] GPS_TRACKER::GPSCoordinates getActPosition() const;
+
+        /**
+         * Lock-free, consistent copy of the state shared between tasks. Safe to call from any task.
+         * */
+        [[nodiscard]] TrackerState snapshot() const;
+
         void onReachedWaypoint(std::function<void(const waypoint &)> callback);
 
         [[nodiscard]] GPS_TRACKER::Timestamp getLastFastFixFileUpdate() const;
@@ -70,8 +98,6 @@ namespace GPS_TRACKER {
     private:
         void checkCollision();
 
-        static double deg2rad(float deg);
-
         void loadPersistState();
 
         void persistState();
@@ -86,15 +112,11 @@ namespace GPS_TRACKER {
 
         unsigned long lastFastFixFileUpdate = 0;
         AudioPlayer::STATE audioPlayerState = AudioPlayer::STOPPED;
-        MQTT::STATE mqttState = MQTT::DISCONNECTED;
-        GSM::STATE gsmState = GSM::DISCONNECTED;
 
-        size_t visitedWaypoints = 0;
+        SeqLock<TrackerState> state; // written by the tracker loop, read from any task
         std::function<void(const waypoint &)> newWaypointReachedCallback;
-        GPS_TRACKER::GPSCoordinates actPosition;
-        Configuration *configuration;
+        ConfigurationStore *configurations;
         esp_sleep_wakeup_cause_t wakeup_reason;
-        uint8_t connectedDevices = 0;
     };
 }
 
@@ -4,7 +4,8 @@
 bool GPS_TRACKER::Tracker::begin() {
     initLogger();
 
-    logger->println(Logging::INFO, "Initialization start....");
+    LOG_INFO(logger, "Initialization start....\n");
+    LOG_INFO(logger, "Automatic light sleep: %d\n", PowerManager::begin());
 
     if (!initSPIFFS()) {
         return false;
@@ -20,9 +21,13 @@ bool GPS_TRACKER::Tracker::begin() {
 
     initAudio();
 
-    logger->printf(Logging::INFO, "Sleep time %d\n", configuration->CONFIG.sleepTime);
+    appliedConfiguration = configurations->get();
+    const motion_config &motionConfig = appliedConfiguration->MOTION_CONFIG;
+    LOG_INFO(logger, "Max. sleep time %d\n", appliedConfiguration->CONFIG.sleepTime);
+    sleepScheduler = new GPS_TRACKER::SleepScheduler();
+    motionDetector = new GNSS::MotionDetector(motionConfig.stationarySpeed, motionConfig.stationaryRadius,
+                                              motionConfig.stationaryTime * 1000, motionConfig.minSatellites);
 
-    esp_sleep_enable_timer_wakeup(configuration->CONFIG.sleepTime * uS_TO_S_FACTOR);
     registerOnReachedWaypoint();
     trackerLoop();
 
@@ -32,7 +37,14 @@ bool GPS_TRACKER::Tracker::begin() {
 void GPS_TRACKER::Tracker::initLogger() {
     Serial.println("Serial logger");
     logger = Logging::Logger::serialLogger(Logging::DEBUG);
-    logger->println(Logging::INFO, "Logger initialized");
+    flightRecorder = new Logging::FlightRecorder();
+    if (flightRecorder->open()) {
+        logger->addSink(flightRecorder, Logging::Logger::FLIGHT_RECORDER_LEVEL, Logging::Logger::FLIGHT_RECORDER_RATE);
+        DefaultEventLoop.every(1000, [this] { flightRecorder->flushStale(); });
+    } else {
+        Serial.println("Flight recorder partition not found");
+    }
+    LOG_INFO(logger, "Logger initialized\n");
 }
 
 void GPS_TRACKER::Tracker::initPins() {
@@ -41,33 +53,52 @@ void GPS_TRACKER::Tracker::initPins() {
 
 void GPS_TRACKER::Tracker::trackerLoop() {
     // TODO: send position less times when audio is playing (or this loop is iterate more than once)
-    DefaultTasker.loopEvery("loop", 500, [&] {
+    DefaultTasker.loop("loop", [&] {
         digitalWrite(LED_PIN, LOW); // turn led on
+        ConfigurationSnapshot configuration = configurations->get();
+        if (configuration != appliedConfiguration) applyConfiguration(configuration);
+        if (millis() - lastTaskStats >= TASK_STATS_PERIOD) {
+            lastTaskStats = millis();
+            logTaskStats();
+        }
+        long sleepTime = 0;
+        int samplingRate = configuration->SLEEP_CONFIG.fastSamplingRate;
         GPS_TRACKER::STATUS_CODE res = sim->sendActPosition();
+        motionDetector->tick(millis());
         switch (res) {
             case GPS_TRACKER::GPS_ACCURACY_TOO_LOW:
-                logger->printf(Logging::ERROR, "Accuracy is too low", res);
+                LOG_ERROR(logger, "Accuracy is too low (cause: %d)\n", res);
                 break;
             case GPS_TRACKER::Ok: {
+                sleepScheduler->addFix(stateManager->getActPosition());
+                updateMotionState();
                 double distance = stateManager->distanceToNextWaypoint();
-                logger->printf(Logging::INFO, "Distance from next waypoint is: %f\n", distance);
-                if (distance > 150) { // don't sleep if the waypoint is close
+                prepareWaypointSound(configuration, distance);
+                GPS_TRACKER::SleepScheduler::Plan plan =
+                        sleepScheduler->plan(configuration->CONFIG, configuration->SLEEP_CONFIG, distance);
+                sleepTime = plan.sleepTime;
+                samplingRate = plan.samplingRate;
+                LOG_INFO(logger, "Distance from next waypoint is: %f, ETA: %f s, speed: %f m/s\n",
+                         distance, plan.eta, plan.speed);
+                if (sleepTime > 0) {
                     shouldSleep = true;
                 } else {
-                    logger->println(Logging::INFO,
-                                    "Distance from next waypoint is too short, sleeping will be skipped");
+                    LOG_INFO(logger, "Next waypoint could be reached soon, sleeping will be skipped\n");
                 }
                 break;
             }
             case GPS_TRACKER::SENDING_DATA_FAILED:
-                logger->println(Logging::ERROR, "Sending actual position to MQTT failed");
+                LOG_ERROR(logger, "Sending actual position to MQTT failed\n");
                 shouldSleep = false;
                 break;
             case GPS_TRACKER::SERIALIZATION_ERROR:
-                logger->println(Logging::ERROR, "Serialization error");
+                LOG_ERROR(logger, "Serialization error\n");
+                break;
+            case GPS_TRACKER::GNSS_PARKED:
+                LOG_DEBUG(logger, "Parked, GNSS is off until the heartbeat\n");
                 break;
             default:
-                logger->printf(Logging::ERROR, "Unknown error, tracker needs to be restarted. (cause : %d)\n", res);
+                LOG_ERROR(logger, "Unknown error, tracker needs to be restarted. (cause : %d)\n", res);
                 while (audioPlayer->playing()) {
                     Tasker::sleep(100);
                 }
@@ -77,25 +108,77 @@ void GPS_TRACKER::Tracker::trackerLoop() {
                 break;
         }
 
-        if (!audioPlayer->playing() && shouldSleep && stateManager->couldSleep()) {
+        if (!audioPlayer->playing() && shouldSleep && sleepTime > 0 && stateManager->couldSleep()) {
             digitalWrite(LED_PIN, HIGH); // turn off led
             sim->sleep(); // This is not necessary (now), battery lifetime without sleeping SIM module is good enough
-            logger->println(Logging::INFO, "Going to sleep");
+            LOG_INFO(logger, "Going to sleep for %d s\n", sleepTime);
             delay(100);
-            esp_light_sleep_start();
+            if (PowerManager::isAutomaticSleep()) {
+                Tasker::sleep((int) sleepTime * 1000); // the chip sleeps on its own while no power lock is held
+            } else {
+                esp_sleep_enable_timer_wakeup((uint64_t) sleepTime * uS_TO_S_FACTOR);
+                esp_light_sleep_start();
+            }
             shouldSleep = false;
-            logger->println(Logging::INFO, "Wake up");
+            LOG_INFO(logger, "Wake up\n");
+        } else {
+            bool parked = motionDetector->getState() == GNSS::STATIONARY;
+            Tasker::sleep(parked ? configuration->MOTION_CONFIG.parkedSamplingRate : samplingRate);
         }
     });
 }
 
+void GPS_TRACKER::Tracker::logTaskStats() {
+    for (const TaskHandle &task: Tasker::tasks()) {
+        int64_t cpuTime = task->getCpuTime();
+        if (cpuTime >= 0) {
+            LOG_INFO(logger, "Task %s: free stack %u B, CPU %lld ms, %u iterations\n", task->getName(),
+                     task->getStackHighWaterMark(), cpuTime / 1000, task->getIterations());
+        } else {
+            LOG_INFO(logger, "Task %s: free stack %u B, %u iterations\n", task->getName(),
+                     task->getStackHighWaterMark(), task->getIterations());
+        }
+    }
+    LOG_INFO(logger, "Free heap %u B (min. %u B), largest block %u B\n", ESP.getFreeHeap(), ESP.getMinFreeHeap(),
+             ESP.getMaxAllocHeap());
+    LOG_INFO(logger, "Audio read-ahead underruns: %u (%llu ms)\n", audioPipeline->getUnderruns(),
+             audioPipeline->getUnderrunTime() / 1000);
+    LOG_INFO(logger, "Sounds dropped: %u, preempted: %u\n", audioPlayer->getDropped(), audioPlayer->getPreempted());
+}
+
+void GPS_TRACKER::Tracker::updateMotionState() {
+    GNSS::MOTION_STATE previous = motionDetector->getState();
+    GNSS::MOTION_STATE actual = motionDetector->update(stateManager->getActPosition(), millis());
+    if (previous != actual) {
+        sim->setParked(actual == GNSS::STATIONARY);
+        LOG_INFO(logger, "Time spent moving: %d s, parked: %d s\n",
+                 motionDetector->timeIn(GNSS::MOVING), motionDetector->timeIn(GNSS::STATIONARY));
+    }
+}
+
+void GPS_TRACKER::Tracker::applyConfiguration(const GPS_TRACKER::ConfigurationSnapshot &configuration) {
+    const motion_config &motionConfig = configuration->MOTION_CONFIG;
+    motionDetector->configure(motionConfig.stationarySpeed, motionConfig.stationaryRadius,
+                              motionConfig.stationaryTime * 1000, motionConfig.minSatellites);
+    appliedConfiguration = configuration;
+    LOG_INFO(logger, "Configuration reloaded, # waypoints: %d\n", configuration->WAYPOINTS.size());
+}
+
+void GPS_TRACKER::Tracker::prepareWaypointSound(const GPS_TRACKER::ConfigurationSnapshot &configuration,
+                                                double distance) {
+    size_t next = stateManager->getVisitedWaypoints();
+    if (distance <= configuration->AUDIO_CONFIG.prefetchDistance && next < configuration->WAYPOINTS.size()) {
+        audioPlayer->prepareFile(configuration->WAYPOINTS[next].path);
+    }
+}
+
 void GPS_TRACKER::Tracker::registerOnReachedWaypoint() {
     stateManager->onReachedWaypoint([&](const GPS_TRACKER::waypoint &w) {
 //        sim->powerOff();
-        logger->printf(Logging::INFO, "Waypoint no. %d was reached\n", w.id);
-        audioPlayer->enqueueFile(w.path);
+        LOG_INFO(logger, "Waypoint no. %d was reached\n", w.id);
+        audioPlayer->enqueueFile(w.path, AudioPlayer::URGENT);
     });
-    logger->println(Logging::INFO, "OnReachedWaypoint callback registered");
+    LOG_INFO(logger, "OnReachedWaypoint callback registered\n");
 }
 
 bool GPS_TRACKER::Tracker::init() {
@@ -105,48 +188,62 @@ bool GPS_TRACKER::Tracker::init() {
 
 void GPS_TRACKER::Tracker::initAudio() {
 // ------ AUDIO
-    audioOutput.SetPinout(22, 21, 23);
-    audioPlayer = new AudioPlayer::Player(logger, &mp3, &audioOutput, &source, (DEFAULT_VOLUME / 100.0));
+    if (clips.load(CLIP_BANK)) {
+        LOG_INFO(logger, "Clip bank loaded, %u clips\n", clips.size());
+    }
+    ConfigurationSnapshot configuration = configurations->get();
+    const audio_config &audioConfig = configuration->AUDIO_CONFIG;
+    audioPipeline = new AudioPlayer::Pipeline(logger, &clips, audioConfig.readAhead, audioConfig.keepPipeline);
+    audioPipeline->setPinout(22, 21, 23);
+    audioPlayer = new AudioPlayer::Player(logger, audioPipeline, (DEFAULT_VOLUME / 100.0));
+    audioPlayer->setClipBank(&clips);
     audioPlayer->setVolume(DEFAULT_VOLUME);
     audioPlayer->play();
-    logger->println(Logging::INFO, "Audio module initialized");
+    LOG_INFO(logger, "Audio module initialized\n");
 }
 
 void GPS_TRACKER::Tracker::initStateManager() {
 // ------ STATE
-    stateManager = new GPS_TRACKER::StateManager(configuration);
+    stateManager = new GPS_TRACKER::StateManager(configurations);
     stateManager->begin();
-    logger->println(Logging::INFO, "State manager initialized");
+    LOG_INFO(logger, "State manager initialized\n");
 }
 
 bool GPS_TRACKER::Tracker::initModem() {
     // ------ GSM/GPS
-    sim = new GPS_TRACKER::SIM7000G(logger, *configuration, stateManager);
+    sim = new GPS_TRACKER::SIM7000G(logger, configurations, stateManager);
     GPS_TRACKER::STATUS_CODE initRes = sim->init();
     if (initRes != GPS_TRACKER::Ok) {
-        logger->printf(Logging::ERROR, "Modem initialization failed with code: %u\n", initRes);
+        LOG_ERROR(logger, "Modem initialization failed with code: %u\n", initRes);
         return false;
     } else {
-        logger->println(Logging::INFO, "Modem initialized");
+        LOG_INFO(logger, "Modem initialized\n");
         return true;
     }
 }
 
 bool GPS_TRACKER::Tracker::initConfiguration() {
 // ------ CONFIGURATION
-    configuration = new GPS_TRACKER::Configuration();
-    if (!configuration->read()) {
-        logger->println(Logging::ERROR, "GPS TRACKER INITIALIZATION FAILED");
+    configurations = new GPS_TRACKER::ConfigurationStore();
+    uint32_t freeHeap = ESP.getFreeHeap();
+    unsigned long start = micros();
+    GPS_TRACKER::CONFIGURATION_UPDATE result = configurations->load();
+    if (result != GPS_TRACKER::CONFIGURATION_ACCEPTED) {
+        LOG_ERROR(logger, "Configuration %s\n", GPS_TRACKER::ConfigurationStore::toString(result));
+        LOG_ERROR(logger, "GPS TRACKER INITIALIZATION FAILED\n");
         return false;
     } else {
-        logger->printf(Logging::INFO, "Configuration loaded.\n\t # waypoints: %d\n", configuration->WAYPOINTS.size());
+        ConfigurationSnapshot configuration = configurations->get();
+        LOG_INFO(logger, "Configuration loaded from %s in %d us, heap used: %d B\n\t # waypoints: %d\n",
+                 configuration->isFromGamePack() ? "game pack" : CONFIG_PATH.c_str(), micros() - start,
+                 freeHeap - ESP.getFreeHeap(), configuration->WAYPOINTS.size());
         return true;
     }
 }
 
 bool GPS_TRACKER::Tracker::initSPIFFS() {
     if (!SPIFFS.begin()) {
-        logger->println(Logging::ERROR, "SPIFFS init failed.");
+        LOG_ERROR(logger, "SPIFFS init failed.\n");
         return false;
     }
     return true;
@@ -2,11 +2,18 @@
 #define LIGHTWEIGHT_GPS_TRACKER_TRACKER_H
 
 #include "OtaUpdater.h"
-#include "Configuration.h"
+#include "ConfigurationStore.h"
+#include "SleepScheduler.h"
+#include "gnss/MotionDetector.h"
 #include "networking/SIM7000G.h"
 #include "SPIFFS.h"
 #include "audio/Player.h"
+#include "audio/Pipeline.h"
+#include "audio/ClipBank.h"
 #include "AudioFileSourceSPIFFS.h"
+#include "logger/FlightRecorder.h"
+#include "EventLoop.h"
+#include "PowerManager.h"
 
 namespace GPS_TRACKER {
     class Tracker {
@@ -33,20 +40,45 @@ namespace GPS_TRACKER {
 
         void trackerLoop();
 
+        void updateMotionState();
+
+        /**
+         * Applies a newly swapped configuration to the components which are not reading it on their own.
+         * */
+        void applyConfiguration(const GPS_TRACKER::ConfigurationSnapshot &configuration);
+
         void registerOnReachedWaypoint();
 
+        /**
+         * Lets the player prepare the sound of the next waypoint when it is closer than the prefetch distance.
+         * */
+        void prepareWaypointSound(const GPS_TRACKER::ConfigurationSnapshot &configuration, double distance);
+
+        /**
+         * Logs stack usage and CPU time (if FreeRTOS collects it) of all tasks, used to size their stacks.
+         * */
+        void logTaskStats();
+
+        static constexpr unsigned long TASK_STATS_PERIOD = 10 * 60 * 1000; // ms
+        static constexpr const char *CLIP_BANK = "/clips.bin";
+
         String trackerSSID = "TRACKER-N/A";
 
         bool shouldSleep = false;
+        unsigned long lastTaskStats = 0;
         File loggerFile;
         Logging::Logger *logger;
+        Logging::FlightRecorder *flightRecorder;
         GPS_TRACKER::ISIM *sim;
-        GPS_TRACKER::Configuration *configuration;
+        GPS_TRACKER::ConfigurationStore *configurations;
+        GPS_TRACKER::ConfigurationSnapshot appliedConfiguration;
         GPS_TRACKER::StateManager *stateManager;
+        GPS_TRACKER::SleepScheduler *sleepScheduler;
+        GNSS::MotionDetector *motionDetector;
         AudioPlayer::Player *audioPlayer;
-        AudioOutputI2S audioOutput;
-        AudioGeneratorMP3 mp3;
         AudioFileSourceSPIFFS source;
+        AudioPlayer::ClipBank clips{&source};
+        AudioPlayer::Pipeline *audioPipeline;
     };
 }
 
@@ -0,0 +1,139 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_WAYPOINTREADER_H
+#define LIGHTWEIGHT_GPS_TRACKER_WAYPOINTREADER_H
+
+#include <cctype>
+#include <cstddef>
+#include "ArduinoJson.h"
+
+namespace GPS_TRACKER {
+    /**
+     * Streaming reader of the `waypoints` array of `config.json`, only a single waypoint is in RAM at a time.
+     *
+     * The input is anything ArduinoJson reads from which also has `peek()` (e.g. `File` or another `Stream`),
+     * the reading starts at its actual position.
+     * */
+    namespace WaypointReader {
+        static constexpr size_t WAYPOINT_CAPACITY = 256; // single waypoint object
+
+        template<typename TInput>
+        int skipSpace(TInput &input) {
+            while (isspace(input.peek())) input.read();
+            return input.peek();
+        }
+
+        /**
+         * Reads the rest of a string whose opening quote was read already.
+         *
+         * @return true if the string equals `key` (strings with escapes never match, nullptr matches nothing)
+         * */
+        template<typename TInput>
+        bool skipString(TInput &input, const char *key) {
+            bool equal = key != nullptr;
+            size_t matched = 0;
+            for (;;) {
+                int c = input.read();
+                if (c < 0) {
+                    return false;
+                }
+                if (c == '"') {
+                    return equal && key[matched] == '\0';
+                }
+                if (c == '\\') {
+                    input.read();
+                    equal = false;
+                } else if (equal) {
+                    equal = key[matched++] == c;
+                }
+            }
+        }
+
+        /**
+         * Moves `input` right after the opening bracket of the array under `key` in the top-level object.
+         * Keys of nested objects and string values never match.
+         *
+         * @return false if the top-level object has no such array
+         * */
+        template<typename TInput>
+        bool findArray(TInput &input, const char *key) {
+            int depth = 0;
+            bool keyExpected = false; // the next string at the top level is a key
+            for (;;) {
+                int c = input.read();
+                switch (c) {
+                    case -1:
+                        return false;
+                    case '"':
+                        if (depth == 1 && keyExpected) {
+                            keyExpected = false;
+                            if (skipString(input, key) && skipSpace(input) == ':') {
+                                input.read();
+                                if (skipSpace(input) != '[') return false;
+                                input.read();
+                                return true;
+                            }
+                        } else {
+                            skipString(input, nullptr);
+                        }
+                        break;
+                    case '{':
+                    case '[':
+                        keyExpected = depth == 0 && c == '{';
+                        depth++;
+                        break;
+                    case '}':
+                    case ']':
+                        if (--depth <= 0) return false; // end of the top-level object
+                        keyExpected = false;
+                        break;
+                    case ',':
+                        keyExpected = depth == 1;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        /**
+         * Calls `callback(JsonObject)` for every element of the top-level `waypoints` array (only `id`, `lat`, `lon`
+         * and `path` are kept).
+         *
+         * @return false if an element cannot be parsed, true also when there are no waypoints
+         * */
+        template<typename TInput, typename TCallback>
+        bool forEachWaypoint(TInput &input, TCallback callback) {
+            if (!findArray(input, "waypoints")) {
+                return true; // no waypoints
+            }
+
+            StaticJsonDocument<64> filter;
+            filter["id"] = true;
+            filter["lat"] = true;
+            filter["lon"] = true;
+            filter["path"] = true;
+
+            if (skipSpace(input) == ']') {
+                return true; // empty array
+            }
+
+            DynamicJsonDocument element(WAYPOINT_CAPACITY);
+            for (;;) {
+                DeserializationError error = deserializeJson(element, input, DeserializationOption::Filter(filter));
+                if (error != DeserializationError::Ok) {
+                    return false;
+                }
+                callback(element.as<JsonObject>());
+                int next = skipSpace(input);
+                input.read();
+                if (next == ']') {
+                    return true;
+                }
+                if (next != ',') {
+                    return false;
+                }
+            }
+        }
+    }
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_WAYPOINTREADER_H
@@ -0,0 +1,180 @@
+#include "Waypoints.h"
+#include <cmath>
+#include <cstring>
+
+static constexpr double FIXED_POINT_SCALE = 1e7;
+
+static int32_t toFixedPoint(double deg) {
+    return (int32_t) lround(deg * FIXED_POINT_SCALE);
+}
+
+static float fromFixedPoint(int32_t value) {
+    return (float) (value / FIXED_POINT_SCALE);
+}
+
+GPS_TRACKER::PathTable::PathTable(const PathTable &other) {
+    *this = other;
+}
+
+GPS_TRACKER::PathTable &GPS_TRACKER::PathTable::operator=(const PathTable &other) {
+    if (this == &other) return *this;
+    ownedData = other.ownedData;
+    ownedOffsets = other.ownedOffsets;
+    bool owned = other.data == other.ownedData.data();
+    data = owned ? ownedData.data() : other.data;
+    offsets = owned ? ownedOffsets.data() : other.offsets;
+    count = other.count;
+    return *this;
+}
+
+uint16_t GPS_TRACKER::PathTable::intern(const char *path) {
+    if (data != ownedData.data()) clear(); // mapped table cannot be extended
+
+    // there are just a few distinct paths, linear search is cheaper than a hash map on the heap
+    for (size_t i = 0; i < ownedOffsets.size(); i++) {
+        if (strcmp(&ownedData[ownedOffsets[i]], path) == 0) return (uint16_t) i;
+    }
+    size_t length = strlen(path) + 1;
+    if (ownedOffsets.size() >= NO_PATH || ownedData.size() + length > UINT16_MAX) return NO_PATH;
+
+    ownedOffsets.push_back((uint16_t) ownedData.size());
+    ownedData.insert(ownedData.end(), path, path + length);
+    data = ownedData.data();
+    offsets = ownedOffsets.data();
+    count = ownedOffsets.size();
+    return (uint16_t) (count - 1);
+}
+
+void GPS_TRACKER::PathTable::map(const char *pathData, const uint16_t *pathOffsets, size_t pathsCount) {
+    ownedData.clear();
+    ownedData.shrink_to_fit();
+    ownedOffsets.clear();
+    ownedOffsets.shrink_to_fit();
+    data = pathData;
+    offsets = pathOffsets;
+    count = pathsCount;
+}
+
+const char *GPS_TRACKER::PathTable::get(uint16_t index) const {
+    return &data[offsets[index]];
+}
+
+size_t GPS_TRACKER::PathTable::size() const {
+    return count;
+}
+
+void GPS_TRACKER::PathTable::clear() {
+    ownedData.clear();
+    ownedOffsets.clear();
+    data = ownedData.data();
+    offsets = ownedOffsets.data();
+    count = 0;
+}
+
+GPS_TRACKER::Waypoints::Waypoints(const Waypoints &other) {
+    *this = other;
+}
+
+GPS_TRACKER::Waypoints &GPS_TRACKER::Waypoints::operator=(const Waypoints &other) {
+    if (this == &other) return *this;
+    ownedLats = other.ownedLats;
+    ownedLons = other.ownedLons;
+    ownedIds = other.ownedIds;
+    ownedPathIndexes = other.ownedPathIndexes;
+    paths = other.paths;
+    if (other.lats == other.ownedLats.data()) {
+        viewOwned();
+    } else {
+        lats = other.lats;
+        lons = other.lons;
+        ids = other.ids;
+        pathIndexes = other.pathIndexes;
+        count = other.count;
+    }
+    return *this;
+}
+
+void GPS_TRACKER::Waypoints::reserve(size_t capacity) {
+    ownedLats.reserve(capacity);
+    ownedLons.reserve(capacity);
+    ownedIds.reserve(capacity);
+    ownedPathIndexes.reserve(capacity);
+}
+
+bool GPS_TRACKER::Waypoints::add(size_t id, double lat, double lon, const char *path) {
+    if (lats != ownedLats.data()) clear(); // mapped waypoints cannot be extended
+    if (id > UINT16_MAX) return false;
+    uint16_t pathIndex = paths.intern(path);
+    if (pathIndex == PathTable::NO_PATH) return false;
+
+    ownedLats.push_back(toFixedPoint(lat));
+    ownedLons.push_back(toFixedPoint(lon));
+    ownedIds.push_back((uint16_t) id);
+    ownedPathIndexes.push_back(pathIndex);
+    viewOwned();
+    return true;
+}
+
+void GPS_TRACKER::Waypoints::map(const int32_t *latitudes, const int32_t *longitudes, const uint16_t *identifiers,
+                                 const uint16_t *indexes, size_t waypointsCount,
+                                 const char *pathData, const uint16_t *pathOffsets, size_t pathsCount) {
+    ownedLats.clear();
+    ownedLats.shrink_to_fit();
+    ownedLons.clear();
+    ownedLons.shrink_to_fit();
+    ownedIds.clear();
+    ownedIds.shrink_to_fit();
+    ownedPathIndexes.clear();
+    ownedPathIndexes.shrink_to_fit();
+    lats = latitudes;
+    lons = longitudes;
+    ids = identifiers;
+    pathIndexes = indexes;
+    count = waypointsCount;
+    paths.map(pathData, pathOffsets, pathsCount);
+}
+
+void GPS_TRACKER::Waypoints::clear() {
+    ownedLats.clear();
+    ownedLons.clear();
+    ownedIds.clear();
+    ownedPathIndexes.clear();
+    paths.clear();
+    viewOwned();
+}
+
+size_t GPS_TRACKER::Waypoints::size() const {
+    return count;
+}
+
+bool GPS_TRACKER::Waypoints::empty() const {
+    return count == 0;
+}
+
+GPS_TRACKER::waypoint GPS_TRACKER::Waypoints::operator[](size_t index) const {
+    return {ids[index], lat(index), lon(index), path(index)};
+}
+
+float GPS_TRACKER::Waypoints::lat(size_t index) const {
+    return fromFixedPoint(lats[index]);
+}
+
+float GPS_TRACKER::Waypoints::lon(size_t index) const {
+    return fromFixedPoint(lons[index]);
+}
+
+uint16_t GPS_TRACKER::Waypoints::id(size_t index) const {
+    return ids[index];
+}
+
+const char *GPS_TRACKER::Waypoints::path(size_t index) const {
+    return paths.get(pathIndexes[index]);
+}
+
+void GPS_TRACKER::Waypoints::viewOwned() {
+    lats = ownedLats.data();
+    lons = ownedLons.data();
+    ids = ownedIds.data();
+    pathIndexes = ownedPathIndexes.data();
+    count = ownedLats.size();
+}
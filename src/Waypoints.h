@@ -0,0 +1,122 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_WAYPOINTS_H
+#define LIGHTWEIGHT_GPS_TRACKER_WAYPOINTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GPS_TRACKER {
+    /**
+     * Waypoint materialized from `Waypoints` storage. `path` points into the path table of the storage.
+     * */
+    struct waypoint {
+        uint16_t id;
+        float lat;
+        float lon;
+        const char *path;
+    };
+
+    /**
+     * Interned strings stored back to back in one buffer. Equal strings share a single copy.
+     *
+     * The table either owns its buffer (filled by `intern`) or views a buffer owned by someone else (`map`),
+     * e.g. memory mapped flash.
+     * */
+    class PathTable {
+    public:
+        PathTable() = default;
+
+        PathTable(const PathTable &other);
+
+        PathTable &operator=(const PathTable &other);
+
+        /**
+         * @return index of the string, `NO_PATH` if the table is full
+         * */
+        uint16_t intern(const char *path);
+
+        /**
+         * Views external, NUL separated `pathData` with `count` strings starting at `pathOffsets`.
+         * */
+        void map(const char *pathData, const uint16_t *pathOffsets, size_t count);
+
+        /**
+         * Pointers are stable as long as no other string is interned.
+         * */
+        [[nodiscard]] const char *get(uint16_t index) const;
+
+        [[nodiscard]] size_t size() const;
+
+        void clear();
+
+        static constexpr uint16_t NO_PATH = UINT16_MAX;
+
+    private:
+        std::vector<char> ownedData;
+        std::vector<uint16_t> ownedOffsets;
+        const char *data = nullptr;
+        const uint16_t *offsets = nullptr;
+        size_t count = 0;
+    };
+
+    /**
+     * Waypoints stored as a structure of arrays (12 bytes per waypoint + shared paths).
+     *
+     * Coordinates are fixed point numbers (1e-7 deg) kept in separate arrays, so scanning positions does not touch
+     * ids or paths. Paths are indexes into the interned path table. Like `PathTable`, the arrays are either owned
+     * (filled by `add`) or mapped from external memory.
+     * */
+    class Waypoints {
+    public:
+        Waypoints() = default;
+
+        Waypoints(const Waypoints &other);
+
+        Waypoints &operator=(const Waypoints &other);
+
+        void reserve(size_t count);
+
+        /**
+         * @return false if the waypoint cannot be stored (id or number of distinct paths exceeds 16 bits)
+         * */
+        bool add(size_t id, double lat, double lon, const char *path);
+
+        /**
+         * Views external arrays, nothing is copied. The memory must outlive this object.
+         * */
+        void map(const int32_t *lats, const int32_t *lons, const uint16_t *ids, const uint16_t *pathIndexes,
+                 size_t count, const char *pathData, const uint16_t *pathOffsets, size_t pathsCount);
+
+        void clear();
+
+        [[nodiscard]] size_t size() const;
+
+        [[nodiscard]] bool empty() const;
+
+        [[nodiscard]] waypoint operator[](size_t index) const;
+
+        [[nodiscard]] float lat(size_t index) const;
+
+        [[nodiscard]] float lon(size_t index) const;
+
+        [[nodiscard]] uint16_t id(size_t index) const;
+
+        [[nodiscard]] const char *path(size_t index) const;
+
+    private:
+        void viewOwned();
+
+        std::vector<int32_t> ownedLats;
+        std::vector<int32_t> ownedLons;
+        std::vector<uint16_t> ownedIds;
+        std::vector<uint16_t> ownedPathIndexes;
+        const int32_t *lats = nullptr;
+        const int32_t *lons = nullptr;
+        const uint16_t *ids = nullptr;
+        const uint16_t *pathIndexes = nullptr;
+        size_t count = 0;
+        PathTable paths;
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_WAYPOINTS_H
@@ -0,0 +1,128 @@
+#include "ClipBank.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct __attribute__((packed)) ClipBankHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+};
+
+AudioPlayer::ClipBank::ClipBank(AudioFileSource *fallback) : fallback(fallback) {}
+
+bool AudioPlayer::ClipBank::load(const char *path) {
+    entries.clear();
+    file = SPIFFS.open(path, FILE_READ);
+    if (!file) {
+        return false;
+    }
+    ClipBankHeader header{};
+    if (file.read(reinterpret_cast<uint8_t *>(&header), sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, "CLPB", 4) != 0 || header.version != VERSION) {
+        file.close();
+        return false;
+    }
+    entries.resize(header.count);
+    size_t indexSize = header.count * sizeof(Entry);
+    bool valid = file.read(reinterpret_cast<uint8_t *>(entries.data()), indexSize) == indexSize;
+    for (Entry &entry: entries) {
+        entry.name[NAME_LENGTH - 1] = '\0';
+        valid = valid && entry.offset <= file.size() && entry.length <= file.size() - entry.offset;
+    }
+    if (!valid) {
+        entries.clear();
+        file.close();
+    }
+    return valid;
+}
+
+size_t AudioPlayer::ClipBank::size() const {
+    return entries.size();
+}
+
+const char *AudioPlayer::ClipBank::name(size_t index) const {
+    return index < entries.size() ? entries[index].name : nullptr;
+}
+
+int AudioPlayer::ClipBank::find(const char *name) const {
+    if (name[0] == '/') name++;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (strcmp(entries[i].name, name) == 0) return (int) i;
+    }
+    return NO_CLIP;
+}
+
+bool AudioPlayer::ClipBank::pathOf(size_t index, char *path, size_t size) const {
+    if (index >= entries.size()) {
+        return false;
+    }
+    int length = snprintf(path, size, "%c%u:%s", INDEX_MARK, (unsigned) index, entries[index].name);
+    return length > 0 && (size_t) length < size;
+}
+
+int AudioPlayer::ClipBank::indexOf(const char *path) const {
+    char *end;
+    unsigned long index = strtoul(path + 1, &end, 10);
+    return end != path + 1 && *end == ':' && index < entries.size() ? (int) index : NO_CLIP;
+}
+
+bool AudioPlayer::ClipBank::open(const char *filename) {
+    close();
+    bool reserved = filename[0] == INDEX_MARK;
+    int index = reserved ? indexOf(filename) : find(filename);
+    if (index == NO_CLIP) {
+        return !reserved && fallback->open(filename); // reserved names are never files
+    }
+    clip = &entries[index];
+    position = 0;
+    return file.seek(clip->offset);
+}
+
+uint32_t AudioPlayer::ClipBank::read(void *data, uint32_t len) {
+    if (clip == nullptr) {
+        return fallback->isOpen() ? fallback->read(data, len) : 0;
+    }
+    len = std::min(len, clip->length - position);
+    uint32_t received = file.read(static_cast<uint8_t *>(data), len);
+    position += received;
+    return received;
+}
+
+bool AudioPlayer::ClipBank::seek(int32_t pos, int dir) {
+    if (clip == nullptr) {
+        return fallback->seek(pos, dir);
+    }
+    int64_t target = pos;
+    if (dir == SEEK_CUR) {
+        target += position;
+    } else if (dir == SEEK_END) {
+        target += clip->length;
+    }
+    if (target < 0 || target > clip->length || !file.seek(clip->offset + target)) {
+        return false;
+    }
+    position = target;
+    return true;
+}
+
+bool AudioPlayer::ClipBank::close() {
+    if (clip == nullptr) {
+        return !fallback->isOpen() || fallback->close();
+    }
+    clip = nullptr; // the bank stays open
+    return true;
+}
+
+bool AudioPlayer::ClipBank::isOpen() {
+    return clip != nullptr || fallback->isOpen();
+}
+
+uint32_t AudioPlayer::ClipBank::getSize() {
+    return clip != nullptr ? clip->length : fallback->getSize();
+}
+
+uint32_t AudioPlayer::ClipBank::getPos() {
+    return clip != nullptr ? position : fallback->getPos();
+}
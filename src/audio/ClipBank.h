@@ -0,0 +1,89 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_CLIPBANK_H
+#define LIGHTWEIGHT_GPS_TRACKER_CLIPBANK_H
+
+#include <SPIFFS.h>
+#include <string>
+#include <vector>
+#include "AudioFileSource.h"
+
+namespace AudioPlayer {
+    /**
+     * Audio clips packed into a single file by `tools/clipbank.py`, the file stays open and a clip is a seek.
+     *
+     * Layout (little endian): magic "CLPB", uint16 version, uint16 count, `count` entries (uint32 offset,
+     * uint32 length, char name[24], NUL terminated) and the clips (whole MP3/WAV files).
+     *
+     * As a source it opens clips by name (a leading '/' is ignored, so waypoint paths work unchanged); names
+     * which are not in the bank are opened from `fallback`. The reserved name "#<index>:<name>" made by `pathOf()`
+     * opens the clip at `index` straight, without comparing names.
+     * */
+    class ClipBank : public AudioFileSource {
+    public:
+        static constexpr uint16_t VERSION = 1;
+        static constexpr size_t NAME_LENGTH = 24;
+        static constexpr int NO_CLIP = -1;
+        static constexpr char INDEX_MARK = '#';
+
+        explicit ClipBank(AudioFileSource *fallback);
+
+        /**
+         * Opens the bank and reads its index.
+         *
+         * @return false if the file is missing or damaged, the bank is empty then
+         * */
+        bool load(const char *path);
+
+        [[nodiscard]] size_t size() const;
+
+        /**
+         * @return name of the clip, nullptr if there is no such clip
+         * */
+        [[nodiscard]] const char *name(size_t index) const;
+
+        /**
+         * @return index of the clip, `NO_CLIP` if it is not in the bank
+         * */
+        [[nodiscard]] int find(const char *name) const;
+
+        /**
+         * Writes the reserved name of the clip, its name part only keeps the extension (decoder) and logs readable.
+         *
+         * @return false if there is no such clip or the name does not fit into `size` characters
+         * */
+        bool pathOf(size_t index, char *path, size_t size) const;
+
+        bool open(const char *filename) override;
+
+        uint32_t read(void *data, uint32_t len) override;
+
+        bool seek(int32_t pos, int dir) override;
+
+        bool close() override;
+
+        bool isOpen() override;
+
+        uint32_t getSize() override;
+
+        uint32_t getPos() override;
+
+    private:
+        /**
+         * @return index of the clip in a reserved name, `NO_CLIP` if it is not in the bank
+         * */
+        [[nodiscard]] int indexOf(const char *path) const;
+
+        struct Entry {
+            uint32_t offset;
+            uint32_t length;
+            char name[NAME_LENGTH];
+        };
+
+        AudioFileSource *fallback;
+        fs::File file;
+        std::vector<Entry> entries;
+        const Entry *clip = nullptr; // the open clip, nullptr if none or the fallback is used
+        uint32_t position = 0; // within the clip
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_CLIPBANK_H
@@ -0,0 +1,83 @@
+#include "Pipeline.h"
+#include <strings.h>
+
+AudioPlayer::Pipeline::Pipeline(Logging::Logger *logger, AudioFileSource *files, size_t readAhead, bool persistent) :
+        logger(logger),
+        files(files),
+        readAheadSize(readAhead),
+        persistent(persistent) {}
+
+void AudioPlayer::Pipeline::setPinout(int bclk, int wclk, int dout) {
+    pins[0] = bclk;
+    pins[1] = wclk;
+    pins[2] = dout;
+}
+
+void AudioPlayer::Pipeline::build() {
+    if (output) return;
+    // the I2S driver is installed by the first `begin()` of a decoder, the MP3 buffers are allocated by it too
+    output.reset(new AudioOutputI2S());
+    output->SetPinout(pins[0], pins[1], pins[2]);
+    mp3.reset(new AudioGeneratorMP3());
+    wav.reset(new WavGenerator());
+    if (readAheadSize > 0) {
+        if (ESP.getMaxAllocHeap() >= readAheadSize + READ_AHEAD_RESERVE) {
+            std::lock_guard<std::mutex> lock(readAheadMutex);
+            readAhead.reset(new ReadAheadSource(files, readAheadSize));
+        } else {
+            LOG_ERROR(logger, "Heap is short of the audio read-ahead, files are read directly\n");
+        }
+    }
+    logHeap("built");
+}
+
+bool AudioPlayer::Pipeline::release() {
+    if (persistent || !output) return false;
+    {
+        std::lock_guard<std::mutex> lock(readAheadMutex);
+        if (readAhead) {
+            readAhead->close();
+            underruns += readAhead->getUnderruns();
+            underrunTime += readAhead->getUnderrunTime();
+            readAhead.reset(); // stops the reader task
+        }
+    }
+    files->close();
+    mp3.reset();
+    wav.reset();
+    output.reset(); // uninstalls the I2S driver and frees its DMA buffers
+    logHeap("released");
+    return true;
+}
+
+AudioOutput *AudioPlayer::Pipeline::getOutput() const {
+    return output.get();
+}
+
+AudioFileSource *AudioPlayer::Pipeline::getSource() const {
+    return readAhead ? readAhead.get() : files;
+}
+
+AudioGenerator *AudioPlayer::Pipeline::generatorFor(const std::string &path) const {
+    static const char WAV[] = ".wav";
+    size_t length = sizeof(WAV) - 1;
+    if (path.size() >= length && strcasecmp(path.c_str() + path.size() - length, WAV) == 0) {
+        return wav.get();
+    }
+    return mp3.get();
+}
+
+uint32_t AudioPlayer::Pipeline::getUnderruns() {
+    std::lock_guard<std::mutex> lock(readAheadMutex);
+    return underruns + (readAhead ? readAhead->getUnderruns() : 0);
+}
+
+uint64_t AudioPlayer::Pipeline::getUnderrunTime() {
+    std::lock_guard<std::mutex> lock(readAheadMutex);
+    return underrunTime + (readAhead ? readAhead->getUnderrunTime() : 0);
+}
+
+void AudioPlayer::Pipeline::logHeap(const char *event) {
+    LOG_INFO(logger, "Audio pipeline %s, free heap %u B (min. %u B), largest block %u B\n", event,
+             ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap());
+}
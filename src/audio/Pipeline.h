@@ -0,0 +1,86 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_PIPELINE_H
+#define LIGHTWEIGHT_GPS_TRACKER_PIPELINE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include "AudioGeneratorMP3.h"
+#include "AudioOutputI2S.h"
+#include "logger/Logger.h"
+#include "ReadAheadSource.h"
+#include "WavGenerator.h"
+
+namespace AudioPlayer {
+    /**
+     * The I2S output, the decoders and the read-ahead of the player. The sound task builds them when a sound is
+     * queued and releases them when the queue is empty, so the I2S driver with its DMA buffers and the read-ahead
+     * ring with its task do not take the heap TLS needs while the tracker is silent. A persistent pipeline is built
+     * on the first sound and kept.
+     *
+     * Free heap and the largest free block are logged whenever the pipeline is built or released.
+     * */
+    class Pipeline {
+    public:
+        /**
+         * @param files source the files are read from, it stays open
+         * @param readAhead size of the read-ahead ring in bytes, 0 reads `files` directly
+         * */
+        Pipeline(Logging::Logger *logger, AudioFileSource *files, size_t readAhead, bool persistent);
+
+        void setPinout(int bclk, int wclk, int dout);
+
+        /**
+         * Builds the pipeline unless it is built. Called by the sound task.
+         * */
+        void build();
+
+        /**
+         * Stops and frees the pipeline unless it is persistent. Called by the sound task.
+         *
+         * @return true if the pipeline was released
+         * */
+        bool release();
+
+        /**
+         * The getters are valid between `build()` and `release()`.
+         * */
+        [[nodiscard]] AudioOutput *getOutput() const;
+
+        [[nodiscard]] AudioFileSource *getSource() const;
+
+        /**
+         * @return generator of the file by its extension, WAV or MP3
+         * */
+        [[nodiscard]] AudioGenerator *generatorFor(const std::string &path) const;
+
+        /**
+         * @return number of reads which had to wait for the read-ahead since boot, of all pipelines built
+         * */
+        uint32_t getUnderruns();
+
+        /**
+         * @return total time spent waiting in underruns (us)
+         * */
+        uint64_t getUnderrunTime();
+
+    private:
+        static constexpr size_t READ_AHEAD_RESERVE = 16384; // bytes left for others when the ring is allocated
+
+        void logHeap(const char *event);
+
+        Logging::Logger *logger;
+        AudioFileSource *files;
+        size_t readAheadSize;
+        bool persistent;
+        int pins[3] = {26, 25, 22}; // bclk, wclk, dout, the defaults of `AudioOutputI2S`
+        std::unique_ptr<AudioOutputI2S> output;
+        std::unique_ptr<AudioGeneratorMP3> mp3;
+        std::unique_ptr<WavGenerator> wav;
+        std::mutex readAheadMutex; // `readAhead` is replaced by the sound task while the counters are read
+        std::unique_ptr<ReadAheadSource> readAhead;
+        uint32_t underruns = 0; // of the released read-aheads, guarded by `readAheadMutex`
+        uint64_t underrunTime = 0; // guarded by `readAheadMutex`
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_PIPELINE_H
@@ -1,21 +1,15 @@
 #include "Player.h"
 
-AudioPlayer::Player::Player(Logging::Logger *logger,
-                            AudioGenerator *audioGenerator,
-                            AudioOutput *audioOutput,
-                            AudioFileSource *fileSource,
-                            float volume) :
+AudioPlayer::Player::Player(Logging::Logger *logger, Pipeline *pipeline, float volume) :
         logger(logger),
-        audioGenerator(audioGenerator),
-        audioOutput(audioOutput),
-        fileSource(fileSource),
+        pipeline(pipeline),
         volume(volume) {
     init();
 }
 
 
 void AudioPlayer::Player::init() {
-    this->audioGenerator->begin(this->fileSource, this->audioOutput);
+    work = xSemaphoreCreateBinary();
 }
 
 /**
@@ -23,74 +17,216 @@ void AudioPlayer::Player::init() {
  * */
 void AudioPlayer::Player::play() {
     SoundTasker.loop("sound", [this] {
-        if (!audioGenerator->loop()) {
-            audioGenerator->stop();
-            playingUninterruptible = false;
-            isPlaying = false;
+        xSemaphoreTake(work, portMAX_DELAY);
+        GPS_TRACKER::PowerLock::Guard power(GPS_TRACKER::PowerManager::AUDIO);
+        pipeline->build();
+        volumeChanged = true; // the output may be a new one
+        setOutputEnabled(true);
+        while (prepareNext()) {
+            // until a file is queued or another one is to be prepared
+            if (xSemaphoreTake(work, pdMS_TO_TICKS(PREPARED_TIMEOUT)) != pdTRUE) break;
         }
-        if (!audioGenerator->isRunning()) {
-            audioGenerator->stop();
-            audioGenerator->desync();
-            playingUninterruptible = false;
-            isPlaying = false;
-            playNext();
+        while (playNext()) {
+            decode();
+        }
+        dropPrepared();
+        audioGenerator = nullptr;
+        if (pipeline->release()) {
+            outputStopped = false; // the driver is uninstalled, the next output installs and starts it again
+        } else {
+            setOutputEnabled(false);
+        }
+    }, {10000, SOUND_PRIORITY});
+}
+
+void AudioPlayer::Player::decode() {
+    bool first = true;
+    while (!interrupted && audioGenerator->isRunning()) {
+        if (volumeChanged.exchange(false)) {
+            pipeline->getOutput()->SetGain(volume);
+        }
+        if (!audioGenerator->loop()) break;
+        if (first) {
+            first = false;
+            LOG_INFO(logger, "Sound started %lld us after it was queued\n", esp_timer_get_time() - queuedAt);
         }
-    });
+        Tasker::yield(); // the DMA buffers are full
+    }
+    audioGenerator->stop();
+    audioGenerator->desync();
+    playingUninterruptible = false;
+    if (interrupted) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!queue.empty()) preempted++; // not by `stop()`, it empties the queue
+    }
+}
+
+void AudioPlayer::Player::setOutputEnabled(bool enabled) {
+    // the driver is installed (and started) by the first `begin()` of the output
+    if (enabled && outputStopped) {
+        i2s_start(I2S_PORT);
+    } else if (!enabled) {
+        i2s_stop(I2S_PORT);
+    }
+    outputStopped = !enabled;
 }
 
 bool AudioPlayer::Player::setVolume(int newVolume) {
     if (newVolume < 0 || newVolume > 200) {
-        logger->printf(Logging::INFO, "Volume is out of range (value %d)\n", newVolume);
+        LOG_INFO(logger, "Volume is out of range (value %d)\n", newVolume);
         return false;
     }
     volume = (float) newVolume / 100;
-    audioOutput->SetGain(volume);
-    logger->printf(Logging::INFO, "Volume set to %f\n", volume);
+    volumeChanged = true;
+    LOG_INFO(logger, "Volume set to %f\n", volume.load());
     return true;
 }
 
 void AudioPlayer::Player::selectFile(const Sound &sound) {
-    playingUninterruptible = sound.uninterruptible;
-    fileSource->open(sound.path.c_str());
-    if (!audioGenerator->isRunning()) {
-        audioGenerator->begin(fileSource, audioOutput);
+    queuedAt = sound.queuedAt;
+    if (!preparedPath.empty() && sound.path == preparedPath) {
+        preparedPath.clear();
+        return; // opened, read ahead and the decoder started already
     }
+    dropPrepared();
+    startFile(sound.path);
 }
 
-void AudioPlayer::Player::enqueueFile(const std::string &path, bool uninterruptible) {
-    std::lock_guard<std::mutex> lock(queueMutex);
-    fileQueue.push(Sound(path, uninterruptible));
+void AudioPlayer::Player::startFile(const std::string &path) {
+    AudioFileSource *fileSource = pipeline->getSource();
+    audioGenerator = pipeline->generatorFor(path);
+    fileSource->open(path.c_str());
+    if (!audioGenerator->begin(fileSource, pipeline->getOutput())) {
+        LOG_ERROR(logger, "Unsupported or damaged file: %s\n", path.c_str());
+    }
 }
 
-void AudioPlayer::Player::playNext() {
-    std::lock_guard<std::mutex> lock(queueMutex);
+bool AudioPlayer::Player::enqueueFile(const std::string &path, Priority priority, bool uninterruptible) {
+    if (path.size() >= Sound::PATH_LENGTH) {
+        LOG_ERROR(logger, "File path is too long: %s\n", path.c_str());
+        return false;
+    }
+    Sound sound(path.c_str(), priority, uninterruptible);
+    return enqueue(&sound, 1);
+}
 
-    if (fileQueue.empty()) {
-        isPlaying = false;
-        return;
+bool AudioPlayer::Player::enqueueClips(const std::vector<uint16_t> &clips, Priority priority, bool uninterruptible) {
+    if (clips.size() > SoundQueue::CAPACITY) {
+        LOG_ERROR(logger, "%u clips do not fit into the queue\n", clips.size());
+        return false;
+    }
+    Sound sounds[SoundQueue::CAPACITY];
+    size_t count = 0;
+    for (uint16_t clip: clips) {
+        // the bank opens the reserved name by the index, the clip names are not searched
+        char path[Sound::PATH_LENGTH];
+        if (clipBank == nullptr || !clipBank->pathOf(clip, path, sizeof(path))) {
+            LOG_ERROR(logger, "Clip %u is not in the bank\n", clip);
+            return false;
+        }
+        sounds[count++] = Sound(path, priority, uninterruptible);
     }
-    logger->printf(Logging::INFO, "Playing next file: %s\n", fileQueue.front().path.c_str());
-    selectFile(fileQueue.front());
-    fileQueue.pop();
-    isPlaying = true;
+    return enqueue(sounds, count);
+}
+
+bool AudioPlayer::Player::enqueueClip(uint16_t clip, Priority priority, bool uninterruptible) {
+    return enqueueClips({clip}, priority, uninterruptible);
 }
 
-void AudioPlayer::Player::playFile(const std::string &path, bool uninterruptible) {
-    if (playingUninterruptible) {
+bool AudioPlayer::Player::enqueue(const Sound *sounds, size_t count) {
+    bool kept = true;
+    {
         std::lock_guard<std::mutex> lock(queueMutex);
-        logger->printf(Logging::INFO, "File enqueued to front: %s\n", path.c_str());
-        fileQueue.push(Sound(path, uninterruptible));
-    } else {
-        selectFile(Sound(path, uninterruptible));
+        for (size_t i = 0; i < count; i++) {
+            kept = queue.push(sounds[i]) && kept;
+            if (isPlaying && !playingUninterruptible && sounds[i].priority > playingPriority) {
+                interrupted = true;
+            }
+        }
+        isPlaying = true;
+        lastPrepared.clear();
     }
+    if (!kept) {
+        LOG_INFO(logger, "Sound queue is full, a file was dropped\n");
+    }
+    xSemaphoreGive(work);
+    return kept;
+}
+
+void AudioPlayer::Player::setClipBank(const ClipBank *bank) {
+    clipBank = bank;
+}
+
+bool AudioPlayer::Player::playNext() {
+    Sound sound;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!queue.pop(sound)) {
+            isPlaying = false;
+            return false;
+        }
+        interrupted = false; // an interruption is meant for the sound playing before
+        playingPriority = sound.priority;
+        playingUninterruptible = sound.uninterruptible;
+    }
+    // the file is opened without the lock, so queueing never waits for the file system
+    LOG_INFO(logger, "Playing next file: %s\n", sound.path);
+    selectFile(sound);
+    return true;
+}
+
+bool AudioPlayer::Player::prepareNext() {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        path.swap(prepareRequest);
+        if (path.empty() || !queue.empty()) return false;
+    }
+    LOG_DEBUG(logger, "Preparing file: %s\n", path.c_str());
+    dropPrepared();
+    startFile(path);
+    preparedPath = path;
+    return true;
+}
+
+void AudioPlayer::Player::dropPrepared() {
+    if (preparedPath.empty()) return;
+    audioGenerator->stop();
+    audioGenerator->desync();
+    preparedPath.clear();
+}
+
+void AudioPlayer::Player::prepareFile(const std::string &path) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (path == prepareRequest || path == lastPrepared) return;
+        prepareRequest = path;
+        lastPrepared = path;
+    }
+    xSemaphoreGive(work);
+}
+
+bool AudioPlayer::Player::playFile(const std::string &path, bool uninterruptible) {
+    return enqueueFile(path, URGENT, uninterruptible);
 }
 
 void AudioPlayer::Player::stop() {
-    this->audioGenerator->desync();
-    this->audioGenerator->stop();
-    this->audioOutput->stop();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.clear();
+        interrupted = true;
+    }
 }
 
 bool AudioPlayer::Player::playing() const {
     return this->isPlaying;
 }
+
+uint32_t AudioPlayer::Player::getDropped() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queue.getDropped();
+}
+
+uint32_t AudioPlayer::Player::getPreempted() const {
+    return preempted;
+}
@@ -2,63 +2,160 @@
 #define LIGHTWEIGHT_GPS_TRACKER_PLAYER_H
 
 #include <Tasker.h>
-#include <queue>
+#include <atomic>
 #include <mutex>
-#include <utility>
-#include "AudioFileSourceID3.h"
-#include "AudioFileSourceSD.h"
-#include "AudioGeneratorMP3.h"
-#include "AudioOutputI2S.h"
+#include <vector>
+#include <driver/i2s.h>
+#include <freertos/semphr.h>
 #include "StateManager.h"
 #include "logger/Logger.h"
+#include "PowerManager.h"
+#include "ClipBank.h"
+#include "Pipeline.h"
+#include "SoundQueue.h"
 
 namespace AudioPlayer {
-    struct Sound {
-        explicit Sound(std::string p, bool i = false) {
-            path = std::move(p);
-            uninterruptible = i;
-        }
-
-        std::string path;
-        bool uninterruptible;
-    };
-
+    /**
+     * Plays queued files on the sound task. The task blocks until a file is queued, then decodes until the queue
+     * is empty and stops the I2S output again, so the core sleeps between sounds. The output and the decoders are
+     * taken from `pipeline`, built for the sounds and released afterwards.
+     *
+     * Files are played by their priority. A file of a higher priority than the playing one stops it (unless it is
+     * uninterruptible) after the frame being decoded, the stopped sound is not resumed.
+     * */
     class Player {
     public:
-        Player(Logging::Logger *logger, AudioGenerator *audioGenerator, AudioOutput *audioOutput, AudioFileSource *fileSource,
-               float volume);
+        Player(Logging::Logger *logger, Pipeline *pipeline, float volume);
 
         void init();
 
+        /**
+         * Starts the sound task.
+         * */
         void play();
 
         void stop();
 
-        void enqueueFile(const std::string &path, bool uninterruptible = false);
+        /**
+         * Queues the file, it may be called from any task. The queue holds `SoundQueue::CAPACITY` files, when it
+         * is full the file of the lowest priority is dropped.
+         *
+         * @return false if the path is too long or a file was dropped
+         * */
+        bool enqueueFile(const std::string &path, Priority priority = NORMAL, bool uninterruptible = false);
+
+        /**
+         * Plays clips of the bank given to `setClipBank()` right after each other, e.g. an announcement composed
+         * of words. Nothing else of the same or a lower priority queued meanwhile gets between them.
+         *
+         * @return false if any of the clips is not in the bank or there are more than `SoundQueue::CAPACITY` clips
+         *         (nothing is queued then) or a file was dropped
+         * */
+        bool enqueueClips(const std::vector<uint16_t> &clips, Priority priority = NORMAL,
+                          bool uninterruptible = false);
+
+        bool enqueueClip(uint16_t clip, Priority priority = NORMAL, bool uninterruptible = false);
+
+        /**
+         * Bank of the clips for `enqueueClips()`, the bank must also be (or be read by) the file source.
+         * Call before `play()`.
+         * */
+        void setClipBank(const ClipBank *bank);
 
-        void playFile(const std::string &path, bool uninterruptible = false);
+        /**
+         * Queues the file as `URGENT`, it interrupts the actual sound unless that is uninterruptible or urgent.
+         * */
+        bool playFile(const std::string &path, bool uninterruptible = false);
 
         /**
-         * @param newVolume New volume in % [range: 0 to 200]
+         * Opens the file and starts the decoder ahead, so the sound starts right away when the file is queued
+         * (within `PREPARED_TIMEOUT`). Repeated calls for the same file do nothing until a file is queued.
+         * */
+        void prepareFile(const std::string &path);
+
+        /**
+         * @param newVolume New volume in % [range: 0 to 200], applied from the next decoded frame
          * */
         bool setVolume(int newVolume);
 
         bool playing() const;
+
+        /**
+         * @return number of files dropped since boot because the queue was full
+         * */
+        uint32_t getDropped();
+
+        /**
+         * @return number of sounds stopped since boot by a file of a higher priority
+         * */
+        uint32_t getPreempted() const;
     private:
+        static constexpr UBaseType_t SOUND_PRIORITY = 2; // above the readers of files
+        static constexpr uint32_t PREPARED_TIMEOUT = 60000; // ms, the output runs while a file waits prepared
+        static constexpr i2s_port_t I2S_PORT = I2S_NUM_0; // the port `AudioOutputI2S` uses by default
+
+        /**
+         * Queues the sounds under a single lock, interrupts the actual sound if it is outranked.
+         *
+         * @return false if a sound was dropped
+         * */
+        bool enqueue(const Sound *sounds, size_t count);
+
+        /**
+         * Pops the next file and starts decoding it.
+         *
+         * @return false if the queue is empty
+         * */
+        bool playNext();
+
+        /**
+         * Prepares the requested file (instead of the one prepared before) if nothing is queued.
+         *
+         * @return true if a file was prepared
+         * */
+        bool prepareNext();
 
-        void playNext();
+        /**
+         * Stops the decoder of a prepared file which was not played.
+         * */
+        void dropPrepared();
 
         void selectFile(const Sound &sound);
 
+        /**
+         * Opens the file and starts the generator of its format.
+         * */
+        void startFile(const std::string &path);
+
+        /**
+         * Decodes the actual file until it ends or is interrupted by a file of a higher priority or `stop()`.
+         * */
+        void decode();
+
+        /**
+         * Starts or stops the I2S clocks, the driver keeps the APB clock (and the chip awake) while they run.
+         * */
+        void setOutputEnabled(bool enabled);
+
         Logging::Logger *logger;
-        std::mutex queueMutex; // access to queue must be exclusive
-        AudioGenerator *audioGenerator;
-        AudioOutput *audioOutput;
-        AudioFileSource *fileSource;
-        float volume;
-        bool playingUninterruptible = false;
-        std::queue<Sound> fileQueue;
-        bool isPlaying = false;
+        std::mutex queueMutex; // access to queue must be exclusive, it is held for a copy of a sound at most
+        Pipeline *pipeline;
+        AudioGenerator *audioGenerator = nullptr; // of the actual file
+        std::atomic<float> volume;
+        std::atomic<bool> volumeChanged{true}; // the gain is set on the output by the sound task
+        std::atomic<bool> playingUninterruptible{false};
+        SoundQueue queue; // guarded by `queueMutex`
+        Priority playingPriority = NORMAL; // of the actual sound, guarded by `queueMutex`
+        std::atomic<bool> isPlaying{false};
+        std::atomic<bool> interrupted{false}; // a file of a higher priority was queued or `stop()` called
+        std::atomic<uint32_t> preempted{0};
+        const ClipBank *clipBank = nullptr;
+        std::string prepareRequest; // guarded by `queueMutex`
+        std::string lastPrepared; // guarded by `queueMutex`, a file is prepared once until something is queued
+        std::string preparedPath; // the decoder is started on it, used by the sound task only
+        int64_t queuedAt = 0; // of the actual sound
+        SemaphoreHandle_t work; // given whenever a file is queued or prepared
+        bool outputStopped = false; // by `setOutputEnabled()`, used by the sound task only
     };
 }
 
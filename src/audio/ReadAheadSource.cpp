@@ -0,0 +1,159 @@
+#include "ReadAheadSource.h"
+#include <algorithm>
+#include <cstring>
+
+AudioPlayer::ReadAheadSource::ReadAheadSource(AudioFileSource *source, size_t depth) :
+        source(source),
+        ring(std::max(depth, (size_t) CHUNK_SIZE)) {
+    reader = SoundTasker.loop("read-ahead", [this] { fill(); }, {4096, READER_PRIORITY});
+}
+
+AudioPlayer::ReadAheadSource::~ReadAheadSource() {
+    reader->cancel();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        changed.notify_all();
+    }
+    while (reader->isRunning()) {
+        Tasker::sleep(1);
+    }
+}
+
+bool AudioPlayer::ReadAheadSource::open(const char *filename) {
+    std::lock_guard<std::mutex> sourceLock(sourceMutex);
+    bool result = source->open(filename);
+    std::lock_guard<std::mutex> lock(mutex);
+    reset(0);
+    opened = result;
+    changed.notify_all();
+    return result;
+}
+
+uint32_t AudioPlayer::ReadAheadSource::read(void *data, uint32_t len) {
+    auto *bytes = static_cast<uint8_t *>(data);
+    std::unique_lock<std::mutex> lock(mutex);
+    bool starting = !primed; // the first bytes after an open or a seek are expected to take a while
+    uint32_t done = take(bytes, len);
+    if (done < len && opened && !end) {
+        int64_t start = esp_timer_get_time();
+        uint32_t buffered = done;
+        do {
+            changed.wait(lock, [this] { return count > 0 || end || !opened; });
+            done += take(bytes + done, len - done);
+        } while (done < len && opened && !end);
+        if (!starting && done > buffered) { // waiting for the end of the file is no underrun either
+            underruns++;
+            underrunTime += esp_timer_get_time() - start;
+        }
+    }
+    return done;
+}
+
+uint32_t AudioPlayer::ReadAheadSource::readNonBlock(void *data, uint32_t len) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return take(static_cast<uint8_t *>(data), len);
+}
+
+bool AudioPlayer::ReadAheadSource::seek(int32_t pos, int dir) {
+    std::lock_guard<std::mutex> sourceLock(sourceMutex);
+    std::lock_guard<std::mutex> lock(mutex);
+    int64_t target = pos;
+    if (dir == SEEK_CUR) {
+        target += position;
+    } else if (dir == SEEK_END) {
+        target += source->getSize();
+    }
+    if (target < 0) return false;
+    if (target >= position && target <= position + count) {
+        uint32_t skip = target - position;
+        head = (head + skip) % ring.size();
+        count -= skip;
+        position += skip;
+    } else {
+        if (!source->seek((int32_t) target, SEEK_SET)) return false;
+        reset(target);
+    }
+    changed.notify_all();
+    return true;
+}
+
+bool AudioPlayer::ReadAheadSource::close() {
+    std::lock_guard<std::mutex> sourceLock(sourceMutex);
+    bool result = source->close();
+    std::lock_guard<std::mutex> lock(mutex);
+    reset(0);
+    opened = false;
+    changed.notify_all();
+    return result;
+}
+
+bool AudioPlayer::ReadAheadSource::isOpen() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return opened;
+}
+
+uint32_t AudioPlayer::ReadAheadSource::getSize() {
+    std::lock_guard<std::mutex> sourceLock(sourceMutex);
+    return source->getSize();
+}
+
+uint32_t AudioPlayer::ReadAheadSource::getPos() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return position;
+}
+
+uint32_t AudioPlayer::ReadAheadSource::getUnderruns() const {
+    return underruns;
+}
+
+uint64_t AudioPlayer::ReadAheadSource::getUnderrunTime() const {
+    return underrunTime;
+}
+
+void AudioPlayer::ReadAheadSource::fill() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return stopping || (opened && !end && count < ring.size()); });
+    if (stopping) return;
+    uint32_t expected = generation;
+    lock.unlock();
+
+    std::lock_guard<std::mutex> sourceLock(sourceMutex);
+    lock.lock();
+    if (generation != expected || !opened || end || count == ring.size()) return; // changed meanwhile, look again
+    size_t tail = (head + count) % ring.size();
+    // the reader is the only writer of the free part of the ring and resets wait for `sourceMutex`
+    auto length = (uint32_t) std::min({ring.size() - count, ring.size() - tail, (size_t) CHUNK_SIZE});
+    lock.unlock();
+    uint32_t received = source->read(ring.data() + tail, length);
+    lock.lock();
+    count += received;
+    end = received < length; // files return less only at their end
+    changed.notify_all();
+}
+
+uint32_t AudioPlayer::ReadAheadSource::take(uint8_t *data, uint32_t len) {
+    uint32_t taken = 0;
+    while (taken < len && count > 0) {
+        auto length = (uint32_t) std::min({(size_t) (len - taken), count, ring.size() - head});
+        memcpy(data + taken, ring.data() + head, length);
+        head = (head + length) % ring.size();
+        count -= length;
+        position += length;
+        taken += length;
+    }
+    if (taken > 0) {
+        primed = true;
+        changed.notify_all();
+    }
+    return taken;
+}
+
+void AudioPlayer::ReadAheadSource::reset(uint32_t position) {
+    head = 0;
+    count = 0;
+    this->position = position;
+    end = false;
+    primed = false;
+    generation++;
+}
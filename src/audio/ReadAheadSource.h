@@ -0,0 +1,101 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_READAHEADSOURCE_H
+#define LIGHTWEIGHT_GPS_TRACKER_READAHEADSOURCE_H
+
+#include <Tasker.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "AudioFileSource.h"
+
+namespace AudioPlayer {
+    /**
+     * Keeps a ring of the upcoming data of `source` filled by a reader task, so the decoder reads from memory and
+     * a flash operation of another task (SPIFFS is locked during writes) stalls only the reader.
+     *
+     * The reader runs below the sound task and sleeps while the ring is full or no file is open. A read which
+     * finds the ring empty waits for the reader and is counted as an underrun (except right after an open or a seek).
+     * */
+    class ReadAheadSource : public AudioFileSource {
+    public:
+        static constexpr uint32_t CHUNK_SIZE = 512; // bytes read from `source` at once
+        static constexpr UBaseType_t READER_PRIORITY = 1; // below the sound task
+
+        /**
+         * @param depth size of the ring in bytes
+         * */
+        ReadAheadSource(AudioFileSource *source, size_t depth);
+
+        /**
+         * Stops the reader, `source` is left as it is.
+         * */
+        ~ReadAheadSource() override;
+
+        bool open(const char *filename) override;
+
+        uint32_t read(void *data, uint32_t len) override;
+
+        /**
+         * Returns only the buffered data.
+         * */
+        uint32_t readNonBlock(void *data, uint32_t len) override;
+
+        /**
+         * Skips forward within the ring, other seeks drop it and refill it from the new position.
+         * */
+        bool seek(int32_t pos, int dir) override;
+
+        bool close() override;
+
+        bool isOpen() override;
+
+        uint32_t getSize() override;
+
+        uint32_t getPos() override;
+
+        /**
+         * @return number of reads which had to wait for the reader since boot
+         * */
+        uint32_t getUnderruns() const;
+
+        /**
+         * @return total time spent waiting in underruns (us)
+         * */
+        uint64_t getUnderrunTime() const;
+
+    private:
+        /**
+         * Reads a chunk of the file into the ring, waits while there is nothing to read. Runs on the reader task.
+         * */
+        void fill();
+
+        /**
+         * Copies up to `len` buffered bytes to `data`. Caller holds `mutex`.
+         * */
+        uint32_t take(uint8_t *data, uint32_t len);
+
+        /**
+         * Drops the buffered data, the ring starts at `position` of the file. Caller holds both locks.
+         * */
+        void reset(uint32_t position);
+
+        AudioFileSource *source;
+        std::mutex sourceMutex; // `source` is used by the reader outside of `mutex`, taken before `mutex`
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<uint8_t> ring;
+        size_t head = 0; // index of the next byte to be read
+        size_t count = 0; // buffered bytes
+        uint32_t position = 0; // in the file, of the byte at `head`
+        uint32_t generation = 0; // of `reset()`, a chunk read before a reset is dropped
+        bool opened = false;
+        bool end = false; // the reader reached the end of the file
+        bool primed = false; // data were read since the last `reset()`
+        bool stopping = false;
+        std::atomic<uint32_t> underruns{0};
+        std::atomic<uint64_t> underrunTime{0};
+        TaskHandle reader;
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_READAHEADSOURCE_H
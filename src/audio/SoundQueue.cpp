@@ -0,0 +1,65 @@
+#include "SoundQueue.h"
+#include <cstring>
+#include <esp_timer.h>
+
+AudioPlayer::Sound::Sound(const char *path, Priority priority, bool uninterruptible) :
+        priority(priority),
+        uninterruptible(uninterruptible),
+        queuedAt(esp_timer_get_time()) {
+    strncpy(this->path, path, PATH_LENGTH - 1);
+}
+
+bool AudioPlayer::SoundQueue::push(const Sound &sound) {
+    bool kept = true;
+    if (count == CAPACITY) {
+        size_t victim = find(true);
+        dropped++;
+        kept = false;
+        if (sounds[victim].priority >= sound.priority) {
+            return false;
+        }
+        // the victim is replaced by the last sound
+        count--;
+        sounds[victim] = sounds[count];
+        sequences[victim] = sequences[count];
+    }
+    sounds[count] = sound;
+    sequences[count] = nextSequence++;
+    count++;
+    return kept;
+}
+
+bool AudioPlayer::SoundQueue::pop(Sound &sound) {
+    if (count == 0) {
+        return false;
+    }
+    size_t next = find(false);
+    sound = sounds[next];
+    count--;
+    sounds[next] = sounds[count];
+    sequences[next] = sequences[count];
+    return true;
+}
+
+void AudioPlayer::SoundQueue::clear() {
+    count = 0;
+}
+
+bool AudioPlayer::SoundQueue::empty() const {
+    return count == 0;
+}
+
+uint32_t AudioPlayer::SoundQueue::getDropped() const {
+    return dropped;
+}
+
+size_t AudioPlayer::SoundQueue::find(bool last) const {
+    size_t found = 0;
+    for (size_t i = 1; i < count; i++) {
+        bool before = sounds[i].priority != sounds[found].priority
+                      ? sounds[i].priority > sounds[found].priority
+                      : sequences[i] - sequences[found] > UINT32_MAX / 2; // wraps around
+        if (before != last) found = i;
+    }
+    return found;
+}
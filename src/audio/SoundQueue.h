@@ -0,0 +1,74 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_SOUNDQUEUE_H
+#define LIGHTWEIGHT_GPS_TRACKER_SOUNDQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace AudioPlayer {
+    enum Priority : uint8_t {
+        BACKGROUND, NORMAL, URGENT
+    };
+
+    struct Sound {
+        static constexpr size_t PATH_LENGTH = 32; // SPIFFS names are 31 characters at most
+
+        Sound() = default;
+
+        /**
+         * The path is cut to `PATH_LENGTH - 1` characters.
+         * */
+        Sound(const char *path, Priority priority, bool uninterruptible);
+
+        char path[PATH_LENGTH] = {};
+        Priority priority = NORMAL;
+        bool uninterruptible = false;
+        int64_t queuedAt = 0; // us, the start latency is measured from here
+    };
+
+    /**
+     * Sounds waiting to be played, the highest priority first and the oldest first within a priority.
+     * The queue never allocates, it is not synchronized.
+     * */
+    class SoundQueue {
+    public:
+        static constexpr size_t CAPACITY = 8;
+
+        /**
+         * Adds the sound. A full queue drops its newest sound of the lowest priority if that is lower than
+         * the priority of `sound`, otherwise `sound` is dropped.
+         *
+         * @return false if a sound was dropped
+         * */
+        bool push(const Sound &sound);
+
+        /**
+         * Removes the sound to be played next.
+         *
+         * @return false if the queue is empty
+         * */
+        bool pop(Sound &sound);
+
+        void clear();
+
+        [[nodiscard]] bool empty() const;
+
+        /**
+         * @return number of sounds dropped since boot because the queue was full
+         * */
+        [[nodiscard]] uint32_t getDropped() const;
+
+    private:
+        /**
+         * @return index of the sound to be played next (`last` false) or to be dropped first (`last` true)
+         * */
+        size_t find(bool last) const;
+
+        Sound sounds[CAPACITY];
+        uint32_t sequences[CAPACITY] = {}; // order of arrival
+        size_t count = 0;
+        uint32_t nextSequence = 0;
+        uint32_t dropped = 0;
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_SOUNDQUEUE_H
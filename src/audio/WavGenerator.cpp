@@ -0,0 +1,226 @@
+#include "WavGenerator.h"
+#include <algorithm>
+#include <cstring>
+
+static const int16_t STEP_TABLE[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+        107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+        876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871,
+        5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+        27086, 29794, 32767
+};
+
+static const int8_t INDEX_TABLE[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static uint16_t le16(const uint8_t *data) {
+    return data[0] | data[1] << 8;
+}
+
+static uint32_t le32(const uint8_t *data) {
+    return le16(data) | (uint32_t) le16(data + 2) << 16;
+}
+
+bool AudioPlayer::WavGenerator::begin(AudioFileSource *source, AudioOutput *output) {
+    if (source == nullptr || output == nullptr || !source->isOpen()) {
+        return false;
+    }
+    file = source;
+    this->output = output;
+    inputLength = inputPosition = 0;
+    decodedCount = decodedPosition = 0;
+    blockRemaining = 0;
+    lastSample[0] = lastSample[1] = 0;
+    if (!readHeader()) {
+        return false;
+    }
+    output->SetRate((int) sampleRate);
+    output->SetBitsPerSample(16);
+    output->SetChannels(channels);
+    if (!output->begin()) {
+        return false;
+    }
+    running = true;
+    return true;
+}
+
+bool AudioPlayer::WavGenerator::loop() {
+    // the last sample read did not fit the output, it goes first
+    if (running && output->ConsumeSample(lastSample)) {
+        do {
+            if (!readSample(lastSample)) {
+                stop();
+                break;
+            }
+        } while (output->ConsumeSample(lastSample));
+    }
+    file->loop();
+    output->loop();
+    return running;
+}
+
+bool AudioPlayer::WavGenerator::stop() {
+    if (!running) {
+        return true;
+    }
+    running = false;
+    output->stop();
+    return file->close();
+}
+
+bool AudioPlayer::WavGenerator::isRunning() {
+    return running;
+}
+
+bool AudioPlayer::WavGenerator::readHeader() {
+    uint8_t riff[12];
+    if (!readBytes(riff, sizeof(riff)) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+    bool formatRead = false;
+    for (;;) {
+        uint8_t chunk[8];
+        if (!readBytes(chunk, sizeof(chunk))) {
+            return false;
+        }
+        uint32_t size = le32(chunk + 4);
+        if (memcmp(chunk, "data", 4) == 0) {
+            dataRemaining = size;
+            break;
+        }
+        uint32_t skip = size + (size & 1); // chunks are aligned to 2 bytes
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (size < sizeof(fmt) || !readBytes(fmt, sizeof(fmt))) {
+                return false;
+            }
+            format = le16(fmt);
+            channels = le16(fmt + 2);
+            sampleRate = le32(fmt + 4);
+            blockAlign = le16(fmt + 12);
+            bitsPerSample = le16(fmt + 14);
+            formatRead = true;
+            skip -= sizeof(fmt);
+        }
+        uint8_t ignored[16];
+        for (; skip > 0; skip -= std::min(skip, (uint32_t) sizeof(ignored))) {
+            if (!readBytes(ignored, std::min(skip, (uint32_t) sizeof(ignored)))) {
+                return false;
+            }
+        }
+    }
+    if (!formatRead || channels == 0 || channels > MAX_CHANNELS || sampleRate == 0) {
+        return false;
+    }
+    if (format == FORMAT_PCM) {
+        return bitsPerSample == 8 || bitsPerSample == 16;
+    }
+    // a block has a header (4 bytes) and groups of 4 bytes of every channel
+    return format == FORMAT_IMA_ADPCM && bitsPerSample == 4 && blockAlign > 4 * channels &&
+           (blockAlign - 4 * channels) % (4 * channels) == 0;
+}
+
+bool AudioPlayer::WavGenerator::readSample(int16_t sample[2]) {
+    if (format == FORMAT_IMA_ADPCM) {
+        if (decodedPosition == decodedCount && !decodeAdpcm()) {
+            return false;
+        }
+        const int16_t *frame = decoded + decodedPosition++ * channels;
+        sample[AudioOutput::LEFTCHANNEL] = frame[0];
+        sample[AudioOutput::RIGHTCHANNEL] = frame[channels - 1];
+        return true;
+    }
+
+    uint8_t frame[2 * MAX_CHANNELS];
+    uint32_t length = bitsPerSample / 8 * channels;
+    if (dataRemaining < length || !readBytes(frame, length)) {
+        return false;
+    }
+    dataRemaining -= length;
+    for (int channel = 0; channel < 2; channel++) {
+        int source = std::min(channel, channels - 1);
+        sample[channel] = bitsPerSample == 16 ? (int16_t) le16(frame + 2 * source)
+                                              : (int16_t) ((frame[source] - 128) * 256);
+    }
+    return true;
+}
+
+bool AudioPlayer::WavGenerator::decodeAdpcm() {
+    uint32_t groupLength = 4 * channels;
+    if (blockRemaining > 0 && blockRemaining < groupLength) {
+        // a truncated group at the end of the block is skipped
+        uint8_t ignored[4 * MAX_CHANNELS];
+        if (!readBytes(ignored, blockRemaining)) {
+            return false;
+        }
+        dataRemaining -= blockRemaining;
+        blockRemaining = 0;
+    }
+    decodedPosition = 0;
+
+    if (blockRemaining == 0) {
+        // the header of every channel holds the first sample
+        blockRemaining = std::min((uint32_t) blockAlign, dataRemaining);
+        if (blockRemaining < groupLength) {
+            return false;
+        }
+        for (int channel = 0; channel < channels; channel++) {
+            uint8_t header[4];
+            if (!readBytes(header, sizeof(header))) {
+                return false;
+            }
+            adpcm[channel].predictor = (int16_t) le16(header);
+            adpcm[channel].index = std::min((int) header[2], 88);
+            decoded[channel] = (int16_t) adpcm[channel].predictor;
+        }
+        blockRemaining -= groupLength;
+        dataRemaining -= groupLength;
+        decodedCount = 1;
+        return true;
+    }
+
+    for (int channel = 0; channel < channels; channel++) {
+        uint8_t group[4];
+        if (!readBytes(group, sizeof(group))) {
+            return false;
+        }
+        for (int i = 0; i < 4; i++) {
+            decoded[2 * i * channels + channel] = decodeNibble(adpcm[channel], group[i] & 0x0F);
+            decoded[(2 * i + 1) * channels + channel] = decodeNibble(adpcm[channel], group[i] >> 4);
+        }
+    }
+    blockRemaining -= groupLength;
+    dataRemaining -= groupLength;
+    decodedCount = 8;
+    return true;
+}
+
+int16_t AudioPlayer::WavGenerator::decodeNibble(AdpcmChannel &channel, uint8_t nibble) {
+    int32_t step = STEP_TABLE[channel.index];
+    int32_t difference = step >> 3;
+    if (nibble & 1) difference += step >> 2;
+    if (nibble & 2) difference += step >> 1;
+    if (nibble & 4) difference += step;
+    channel.predictor += nibble & 8 ? -difference : difference;
+    channel.predictor = std::max<int32_t>(-32768, std::min<int32_t>(32767, channel.predictor));
+    channel.index = std::max<int32_t>(0, std::min<int32_t>(88, channel.index + INDEX_TABLE[nibble]));
+    return (int16_t) channel.predictor;
+}
+
+bool AudioPlayer::WavGenerator::readBytes(void *data, uint32_t length) {
+    auto *bytes = static_cast<uint8_t *>(data);
+    while (length > 0) {
+        if (inputPosition == inputLength) {
+            inputLength = file->read(input, sizeof(input));
+            inputPosition = 0;
+            if (inputLength == 0) {
+                return false;
+            }
+        }
+        uint32_t copied = std::min(length, (uint32_t) (inputLength - inputPosition));
+        memcpy(bytes, input + inputPosition, copied);
+        inputPosition += copied;
+        bytes += copied;
+        length -= copied;
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_WAVGENERATOR_H
+#define LIGHTWEIGHT_GPS_TRACKER_WAVGENERATOR_H
+
+#include "AudioGenerator.h"
+
+namespace AudioPlayer {
+    /**
+     * Plays WAV files with 8/16-bit PCM or 4-bit IMA ADPCM (`tools/convert_audio.py` creates them), mono or stereo.
+     *
+     * Decoding costs a few operations per sample and the generator keeps no buffers but a small read buffer,
+     * unlike the MP3 decoder which allocates ~30 kB and needs a large part of the CPU.
+     * */
+    class WavGenerator : public AudioGenerator {
+    public:
+        bool begin(AudioFileSource *source, AudioOutput *output) override;
+
+        bool loop() override;
+
+        bool stop() override;
+
+        bool isRunning() override;
+
+    private:
+        static constexpr uint16_t FORMAT_PCM = 1;
+        static constexpr uint16_t FORMAT_IMA_ADPCM = 0x11;
+        static constexpr uint16_t MAX_CHANNELS = 2;
+
+        struct AdpcmChannel {
+            int32_t predictor;
+            int32_t index; // into the step table
+        };
+
+        /**
+         * Finds the format and the data chunk.
+         * */
+        bool readHeader();
+
+        bool readSample(int16_t sample[2]);
+
+        /**
+         * Decodes the next group of nibbles (4 bytes of every channel) into `decoded`, starts a new block if needed.
+         * */
+        bool decodeAdpcm();
+
+        int16_t decodeNibble(AdpcmChannel &channel, uint8_t nibble);
+
+        bool readBytes(void *data, uint32_t length);
+
+        uint16_t format = 0;
+        uint16_t channels = 0;
+        uint32_t sampleRate = 0;
+        uint16_t bitsPerSample = 0;
+        uint16_t blockAlign = 0;
+        uint32_t dataRemaining = 0; // bytes of the data chunk not read yet
+        uint32_t blockRemaining = 0; // bytes of the ADPCM block not read yet
+
+        AdpcmChannel adpcm[MAX_CHANNELS] = {};
+        int16_t decoded[8 * MAX_CHANNELS] = {}; // interleaved samples of the last group
+        uint8_t decodedCount = 0;
+        uint8_t decodedPosition = 0;
+
+        uint8_t input[64] = {};
+        uint8_t inputLength = 0;
+        uint8_t inputPosition = 0;
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_WAVGENERATOR_H
@@ -0,0 +1,111 @@
+#include "MotionDetector.h"
+#include <cmath>
+#include "Geo.h"
+
+static const float METERS_PER_DEG_LAT = (float) (GPS_TRACKER::Geo::EARTH_RADIUS * M_PI / 180);
+
+GNSS::MotionDetector::MotionDetector(float stationarySpeed, float stationaryRadius, uint32_t stationaryTime,
+                                     int minSatellites) :
+        stationarySpeed(stationarySpeed),
+        stationaryRadius(stationaryRadius),
+        stationaryTime(stationaryTime),
+        minSatellites(minSatellites) {}
+
+void GNSS::MotionDetector::configure(float speed, float radius, uint32_t time, int satellites) {
+    stationarySpeed = speed;
+    stationaryRadius = radius;
+    stationaryTime = time;
+    minSatellites = satellites;
+}
+
+GNSS::MOTION_STATE GNSS::MotionDetector::update(const GPS_TRACKER::GPSCoordinates &fix, uint32_t nowMs) {
+    tick(nowMs);
+
+    // speed and position of a fix from few satellites are too noisy to decide anything
+    if (fix.satellites < minSatellites) {
+        return state;
+    }
+
+    if (windowLength == 0) {
+        referenceLat = fix.lat;
+        referenceLon = fix.lon;
+        metersPerDegLon = METERS_PER_DEG_LAT * (float) cos(GPS_TRACKER::Geo::deg2rad(fix.lat));
+    }
+    Point local = toLocal(fix);
+
+    if (state == STATIONARY) {
+        float dx = local.x - parkedAt.x;
+        float dy = local.y - parkedAt.y;
+        if (fix.speed > 2 * stationarySpeed || sqrtf(dx * dx + dy * dy) > 2 * stationaryRadius) {
+            state = MOVING;
+            calm = false;
+            clearWindow();
+        }
+        return state;
+    }
+
+    window[windowHead] = local;
+    windowHead = (windowHead + 1) % WINDOW_SIZE;
+    if (windowLength < WINDOW_SIZE) windowLength++;
+
+    Point centroid{};
+    if (fix.speed <= stationarySpeed && windowLength >= 3 && spread(&centroid) <= stationaryRadius) {
+        if (!calm) {
+            calm = true;
+            calmSince = nowMs;
+        } else if (nowMs - calmSince >= stationaryTime) {
+            state = STATIONARY;
+            parkedAt = centroid;
+        }
+    } else {
+        calm = false;
+    }
+    return state;
+}
+
+void GNSS::MotionDetector::tick(uint32_t nowMs) {
+    if (ticking) {
+        stateTime[state] += nowMs - lastTick;
+    }
+    lastTick = nowMs;
+    ticking = true;
+}
+
+GNSS::MOTION_STATE GNSS::MotionDetector::getState() const {
+    return state;
+}
+
+uint32_t GNSS::MotionDetector::timeIn(GNSS::MOTION_STATE s) const {
+    return (uint32_t) (stateTime[s] / 1000);
+}
+
+GNSS::MotionDetector::Point GNSS::MotionDetector::toLocal(const GPS_TRACKER::GPSCoordinates &fix) const {
+    return {
+            (fix.lon - referenceLon) * metersPerDegLon,
+            (fix.lat - referenceLat) * METERS_PER_DEG_LAT
+    };
+}
+
+float GNSS::MotionDetector::spread(Point *centroid) const {
+    float sumX = 0, sumY = 0;
+    for (size_t i = 0; i < windowLength; i++) {
+        sumX += window[i].x;
+        sumY += window[i].y;
+    }
+    centroid->x = sumX / (float) windowLength;
+    centroid->y = sumY / (float) windowLength;
+
+    // standard distance deviation (square root of the summed variances of both axes)
+    float variance = 0;
+    for (size_t i = 0; i < windowLength; i++) {
+        float dx = window[i].x - centroid->x;
+        float dy = window[i].y - centroid->y;
+        variance += dx * dx + dy * dy;
+    }
+    return sqrtf(variance / (float) windowLength);
+}
+
+void GNSS::MotionDetector::clearWindow() {
+    windowLength = 0;
+    windowHead = 0;
+}
@@ -0,0 +1,88 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_MOTIONDETECTOR_H
+#define LIGHTWEIGHT_GPS_TRACKER_MOTIONDETECTOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "Protocol.h"
+
+namespace GNSS {
+    enum MOTION_STATE {
+        MOVING, STATIONARY
+    };
+
+    /**
+     * Detects that the team is waiting on one place.
+     *
+     * The team is stationary when the speed stays below `stationarySpeed` and the recent positions stay within
+     * `stationaryRadius` for `stationaryTime`. Fixes with less than `minSatellites` satellites are not trusted.
+     * The team is moving again as soon as the speed or the distance from the parking place exceeds double
+     * of the thresholds.
+     *
+     * Time spent in each state is accounted, so the effect of parking can be evaluated.
+     * */
+    class MotionDetector {
+    public:
+        MotionDetector(float stationarySpeed, float stationaryRadius, uint32_t stationaryTime, int minSatellites);
+
+        /**
+         * Changes the thresholds, the state and accounted times are kept.
+         * */
+        void configure(float stationarySpeed, float stationaryRadius, uint32_t stationaryTime, int minSatellites);
+
+        /**
+         * @param fix new (filtered) position
+         * @param nowMs monotonic time in ms
+         * @return state after the update
+         * */
+        MOTION_STATE update(const GPS_TRACKER::GPSCoordinates &fix, uint32_t nowMs);
+
+        /**
+         * Accounts the time spent in the current state, call it even when no fix is available.
+         * */
+        void tick(uint32_t nowMs);
+
+        [[nodiscard]] MOTION_STATE getState() const;
+
+        /**
+         * @return time spent in the state since boot in seconds
+         * */
+        [[nodiscard]] uint32_t timeIn(MOTION_STATE state) const;
+
+    private:
+        static constexpr size_t WINDOW_SIZE = 8;
+
+        struct Point {
+            float x;
+            float y;
+        };
+
+        [[nodiscard]] Point toLocal(const GPS_TRACKER::GPSCoordinates &fix) const;
+
+        [[nodiscard]] float spread(Point *centroid) const;
+
+        void clearWindow();
+
+        float stationarySpeed;
+        float stationaryRadius;
+        uint32_t stationaryTime; // in ms
+        int minSatellites;
+
+        MOTION_STATE state = MOVING;
+        std::array<uint64_t, 2> stateTime{}; // in ms
+        uint32_t lastTick = 0;
+        bool ticking = false;
+
+        bool calm = false;
+        uint32_t calmSince = 0;
+        float referenceLat = 0;
+        float referenceLon = 0;
+        float metersPerDegLon = 0;
+        Point parkedAt{};
+        std::array<Point, WINDOW_SIZE> window{};
+        size_t windowLength = 0;
+        size_t windowHead = 0;
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_MOTIONDETECTOR_H
@@ -0,0 +1,123 @@
+#include "PositionFilter.h"
+#include <cmath>
+#include "Geo.h"
+
+// velocity of a fresh track is unknown, (10 m/s)^2 covers everything from standing to running
+static constexpr float INITIAL_VELOCITY_VARIANCE = 100;
+// HDOP below this value is not realistic for the SIM7000 receiver
+static constexpr float MINIMAL_HDOP = 0.5f;
+
+GNSS::PositionFilter::PositionFilter(float uere, float accelerationNoise, float gate, uint8_t maxRejected) :
+        uere(uere),
+        accelerationNoise(accelerationNoise),
+        gate(gate),
+        maxRejected(maxRejected) {}
+
+GNSS::FILTER_RESULT GNSS::PositionFilter::update(float lat, float lon, float hdop, uint32_t timeMs) {
+    float sigma = (hdop > MINIMAL_HDOP ? hdop : MINIMAL_HDOP) * uere;
+    float r = sigma * sigma;
+
+    if (!initialized) {
+        originLat = lat;
+        originLon = lon;
+        metersPerDegLat = (float) (GPS_TRACKER::Geo::EARTH_RADIUS * M_PI / 180);
+        metersPerDegLon = (float) (metersPerDegLat * cos(GPS_TRACKER::Geo::deg2rad(lat)));
+        initialize(0, 0, r, timeMs);
+        return INITIALIZED;
+    }
+
+    float measuredEast = (float) ((lon - originLon) * metersPerDegLon);
+    float measuredNorth = (float) ((lat - originLat) * metersPerDegLat);
+
+    float dt = (float) (timeMs - lastUpdate) / 1000;
+    lastUpdate = timeMs;
+    east.predict(dt, accelerationNoise);
+    north.predict(dt, accelerationNoise);
+
+    float eastInnovation = east.innovation(measuredEast);
+    float northInnovation = north.innovation(measuredNorth);
+    float nis = eastInnovation * eastInnovation / east.innovationVariance(r) +
+                northInnovation * northInnovation / north.innovationVariance(r);
+    if (nis > gate) {
+        if (++rejected >= maxRejected) {
+            initialize(measuredEast, measuredNorth, r, timeMs);
+            return INITIALIZED;
+        }
+        return REJECTED;
+    }
+
+    rejected = 0;
+    east.correct(measuredEast, r);
+    north.correct(measuredNorth, r);
+    return ACCEPTED;
+}
+
+void GNSS::PositionFilter::reset() {
+    initialized = false;
+    rejected = 0;
+}
+
+bool GNSS::PositionFilter::isInitialized() const {
+    return initialized;
+}
+
+float GNSS::PositionFilter::lat() const {
+    return (float) (originLat + north.position / metersPerDegLat);
+}
+
+float GNSS::PositionFilter::lon() const {
+    return (float) (originLon + east.position / metersPerDegLon);
+}
+
+float GNSS::PositionFilter::speed() const {
+    return sqrtf(east.velocity * east.velocity + north.velocity * north.velocity);
+}
+
+float GNSS::PositionFilter::accuracy() const {
+    return sqrtf(east.p00 + north.p00);
+}
+
+void GNSS::PositionFilter::initialize(float measuredEast, float measuredNorth, float r, uint32_t timeMs) {
+    east.init(measuredEast, r);
+    north.init(measuredNorth, r);
+    lastUpdate = timeMs;
+    rejected = 0;
+    initialized = true;
+}
+
+void GNSS::PositionFilter::Axis::init(float z, float r) {
+    position = z;
+    velocity = 0;
+    p00 = r;
+    p01 = 0;
+    p11 = INITIAL_VELOCITY_VARIANCE;
+}
+
+void GNSS::PositionFilter::Axis::predict(float dt, float q) {
+    if (dt <= 0) return;
+    position += velocity * dt;
+    float dt2 = dt * dt;
+    p00 += dt * (2 * p01 + dt * p11) + q * dt2 * dt / 3;
+    p01 += dt * p11 + q * dt2 / 2;
+    p11 += q * dt;
+}
+
+float GNSS::PositionFilter::Axis::innovation(float z) const {
+    return z - position;
+}
+
+float GNSS::PositionFilter::Axis::innovationVariance(float r) const {
+    return p00 + r;
+}
+
+void GNSS::PositionFilter::Axis::correct(float z, float r) {
+    float s = p00 + r;
+    float k0 = p00 / s;
+    float k1 = p01 / s;
+    float y = z - position;
+    position += k0 * y;
+    velocity += k1 * y;
+    p11 -= k1 * p01;
+    p01 -= k0 * p01;
+    p00 -= k0 * p00;
+}
@@ -0,0 +1,93 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_POSITIONFILTER_H
+#define LIGHTWEIGHT_GPS_TRACKER_POSITIONFILTER_H
+
+#include <cstdint>
+
+namespace GNSS {
+    enum FILTER_RESULT {
+        ACCEPTED, // fix was fused into the estimate
+        INITIALIZED, // filter (re)started from the fix
+        REJECTED // fix is an outlier, estimate was only predicted
+    };
+
+    /**
+     * Constant-velocity Kalman filter of the horizontal position (single precision).
+     *
+     * The state is kept in a local east/north frame (meters) anchored at the first fix, both axes are filtered
+     * independently. Measurement noise of each fix is derived from its HDOP, fixes whose innovation does not fit
+     * into the chi-square gate are rejected. Too many consecutive rejections restart the filter from the last fix
+     * (the estimate has probably diverged, e.g. after a long time without signal).
+     * */
+    class PositionFilter {
+    public:
+        /**
+         * @param uere user equivalent range error in meters, measurement sigma = HDOP * UERE
+         * @param accelerationNoise process noise (spectral density of acceleration) in m^2/s^3
+         * @param gate chi-square threshold of normalized innovation squared (2 degrees of freedom)
+         * @param maxRejected number of consecutive outliers after which the filter is restarted
+         * */
+        PositionFilter(float uere, float accelerationNoise, float gate, uint8_t maxRejected);
+
+        /**
+         * @param lat latitude of the fix
+         * @param lon longitude of the fix
+         * @param hdop horizontal dilution of precision reported with the fix
+         * @param timeMs monotonic time of the fix in ms
+         * */
+        FILTER_RESULT update(float lat, float lon, float hdop, uint32_t timeMs);
+
+        void reset();
+
+        [[nodiscard]] bool isInitialized() const;
+
+        [[nodiscard]] float lat() const;
+
+        [[nodiscard]] float lon() const;
+
+        /**
+         * @return speed over ground in m/s
+         * */
+        [[nodiscard]] float speed() const;
+
+        /**
+         * @return standard deviation of the position estimate in meters
+         * */
+        [[nodiscard]] float accuracy() const;
+
+    private:
+        struct Axis {
+            float position = 0;
+            float velocity = 0;
+            float p00 = 0, p01 = 0, p11 = 0; // covariance (symmetric)
+
+            void init(float z, float r);
+
+            void predict(float dt, float q);
+
+            float innovation(float z) const;
+
+            float innovationVariance(float r) const;
+
+            void correct(float z, float r);
+        };
+
+        void initialize(float east, float north, float r, uint32_t timeMs);
+
+        float uere;
+        float accelerationNoise;
+        float gate;
+        uint8_t maxRejected;
+
+        bool initialized = false;
+        uint8_t rejected = 0;
+        uint32_t lastUpdate = 0;
+        double originLat = 0;
+        double originLon = 0;
+        float metersPerDegLat = 0;
+        float metersPerDegLon = 0;
+        Axis east;
+        Axis north;
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_POSITIONFILTER_H
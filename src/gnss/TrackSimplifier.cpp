@@ -0,0 +1,107 @@
+#include "TrackSimplifier.h"
+#include <cmath>
+#include "Geo.h"
+
+static const float METERS_PER_DEG_LAT = (float) (GPS_TRACKER::Geo::EARTH_RADIUS * M_PI / 180);
+
+GNSS::TrackSimplifier::TrackSimplifier(float tolerance, float deadBand, long maxSilence) :
+        tolerance(tolerance),
+        deadBand(deadBand),
+        maxSilence(maxSilence) {}
+
+bool GNSS::TrackSimplifier::add(const GPS_TRACKER::GPSCoordinates &sample, GPS_TRACKER::GPSCoordinates *publish) {
+    proposed = NONE; // a proposal which was not published is decided again with the new sample
+    if (!hasAnchor) {
+        pending[0] = sample;
+        pendingLength = 1;
+        return propose(0, publish);
+    }
+
+    // movements within the dead-band are noise unless they end an excursion which is not published yet
+    bool heartbeat = sample.timestamp - anchor.timestamp >= maxSilence;
+    Point local = toLocal(sample);
+    if (pendingLength == 0 && !heartbeat && sqrtf(local.x * local.x + local.y * local.y) < deadBand) {
+        return false;
+    }
+
+    if (pendingLength == BUFFER_SIZE) {
+        // drops the oldest pending sample, it has not been published for `BUFFER_SIZE` samples
+        for (size_t i = 1; i < pendingLength; i++) pending[i - 1] = pending[i];
+        pendingLength--;
+    }
+    pending[pendingLength] = sample;
+    pendingLength++;
+    size_t newest = pendingLength - 1;
+
+    // on heartbeat the end of the pending segment goes first if the newest sample does not cover it
+    if (pendingLength == BUFFER_SIZE || heartbeat || !fitsCorridor(newest)) {
+        return propose(lastFitting(), publish);
+    }
+    return false;
+}
+
+bool GNSS::TrackSimplifier::flush(GPS_TRACKER::GPSCoordinates *publish) {
+    proposed = NONE;
+    if (pendingLength == 0) return false;
+    return propose(pendingLength - 1, publish);
+}
+
+void GNSS::TrackSimplifier::markPublished() {
+    if (proposed == NONE) return;
+    setAnchor(pending[proposed]);
+    size_t kept = pendingLength - proposed - 1;
+    for (size_t i = 0; i < kept; i++) pending[i] = pending[proposed + 1 + i];
+    pendingLength = kept;
+    proposed = NONE;
+}
+
+void GNSS::TrackSimplifier::reset() {
+    hasAnchor = false;
+    pendingLength = 0;
+    proposed = NONE;
+}
+
+void GNSS::TrackSimplifier::setMaxSilence(long seconds) {
+    maxSilence = seconds;
+}
+
+bool GNSS::TrackSimplifier::propose(size_t index, GPS_TRACKER::GPSCoordinates *publish) {
+    proposed = index;
+    *publish = pending[index];
+    return true;
+}
+
+size_t GNSS::TrackSimplifier::lastFitting() const {
+    size_t end = pendingLength - 1;
+    while (end > 0 && !fitsCorridor(end)) end--;
+    return end;
+}
+
+GNSS::TrackSimplifier::Point GNSS::TrackSimplifier::toLocal(const GPS_TRACKER::GPSCoordinates &coordinates) const {
+    return {
+            (coordinates.lon - anchor.lon) * metersPerDegLon,
+            (coordinates.lat - anchor.lat) * METERS_PER_DEG_LAT
+    };
+}
+
+bool GNSS::TrackSimplifier::fitsCorridor(size_t end) const {
+    // the anchor is the origin of the local frame
+    Point e = toLocal(pending[end]);
+    float lengthSquared = e.x * e.x + e.y * e.y;
+    for (size_t i = 0; i < end; i++) {
+        Point p = toLocal(pending[i]);
+        float t = lengthSquared > 0 ? (p.x * e.x + p.y * e.y) / lengthSquared : 0;
+        if (t < 0) t = 0;
+        if (t > 1) t = 1;
+        float dx = p.x - t * e.x;
+        float dy = p.y - t * e.y;
+        if (dx * dx + dy * dy > tolerance * tolerance) return false;
+    }
+    return true;
+}
+
+void GNSS::TrackSimplifier::setAnchor(const GPS_TRACKER::GPSCoordinates &coordinates) {
+    anchor = coordinates;
+    metersPerDegLon = METERS_PER_DEG_LAT * (float) cos(GPS_TRACKER::Geo::deg2rad(coordinates.lat));
+    hasAnchor = true;
+}
@@ -0,0 +1,90 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_TRACKSIMPLIFIER_H
+#define LIGHTWEIGHT_GPS_TRACKER_TRACKSIMPLIFIER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "Protocol.h"
+
+namespace GNSS {
+    /**
+     * Online track simplification, decides which samples are worth publishing.
+     *
+     * Published points form a polyline (the reconstructed path). A sample is held back as long as all samples since
+     * the last published point fit into a corridor of width `tolerance` around the segment from the last published
+     * point to the newest sample (streaming Douglas-Peucker). While nothing is pending, samples closer than `deadBand`
+     * to the last published point are ignored. When the corridor breaks, the last sample which still fitted is
+     * published. At least one point is published every `maxSilence` seconds (heartbeat), the end of the pending
+     * segment first if the newest sample does not cover it.
+     *
+     * A point is only proposed, the last published point moves when the caller confirms it by `markPublished()`.
+     * A proposal which is not confirmed (the report failed) is decided again with the next sample.
+     * */
+    class TrackSimplifier {
+    public:
+        /**
+         * @param tolerance maximal distance of a dropped sample from the reconstructed path in meters
+         * @param deadBand movements below this distance (meters) are considered as noise
+         * @param maxSilence the longest time without publishing in seconds
+         * */
+        TrackSimplifier(float tolerance, float deadBand, long maxSilence);
+
+        /**
+         * @param sample new position
+         * @param publish the point which should be published (valid if the function returns true)
+         * @return true if a point should be published
+         * */
+        bool add(const GPS_TRACKER::GPSCoordinates &sample, GPS_TRACKER::GPSCoordinates *publish);
+
+        /**
+         * Publish the newest sample regardless of the path (e.g. an important state change).
+         *
+         * @return false if there is no sample which was not published yet
+         * */
+        bool flush(GPS_TRACKER::GPSCoordinates *publish);
+
+        /**
+         * The point proposed by the last `add()` or `flush()` was published, it becomes the start of the next segment.
+         * */
+        void markPublished();
+
+        void reset();
+
+        void setMaxSilence(long seconds);
+
+    private:
+        static constexpr size_t BUFFER_SIZE = 64;
+        static constexpr size_t NONE = SIZE_MAX;
+
+        struct Point {
+            float x;
+            float y;
+        };
+
+        [[nodiscard]] Point toLocal(const GPS_TRACKER::GPSCoordinates &coordinates) const;
+
+        bool propose(size_t index, GPS_TRACKER::GPSCoordinates *publish);
+
+        /**
+         * @return index of the newest pending sample whose segment from the anchor covers all samples before it
+         * */
+        [[nodiscard]] size_t lastFitting() const;
+
+        [[nodiscard]] bool fitsCorridor(size_t end) const;
+
+        void setAnchor(const GPS_TRACKER::GPSCoordinates &coordinates);
+
+        float tolerance;
+        float deadBand;
+        long maxSilence;
+
+        bool hasAnchor = false;
+        GPS_TRACKER::GPSCoordinates anchor;
+        float metersPerDegLon = 0;
+        std::array<GPS_TRACKER::GPSCoordinates, BUFFER_SIZE> pending; // samples after the anchor
+        size_t pendingLength = 0;
+        size_t proposed = NONE; // index of the proposed point in `pending`
+    };
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_TRACKSIMPLIFIER_H
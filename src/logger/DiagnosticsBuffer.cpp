@@ -0,0 +1,80 @@
+#include "DiagnosticsBuffer.h"
+#include "LogSink.h"
+
+Logging::DiagnosticsBuffer::DiagnosticsBuffer(size_t capacity, size_t maxBatch, size_t batchSize, uint32_t batchAge,
+                                              uint32_t bytesPerHour) :
+        // a full buffer together with the drop notice must fit the budget and a single publish,
+        // otherwise it would never be published
+        capacity(std::min({capacity, (size_t) std::max(0, (int) maxBatch - (int) BATCH_OVERHEAD),
+                           (size_t) std::max(0, (int) bytesPerHour - (int) BATCH_OVERHEAD)})),
+        batchSize(std::min(batchSize, this->capacity)),
+        batchAge(batchAge),
+        bytesPerHour(bytesPerHour),
+        tokens(bytesPerHour) {
+    static_assert(BATCH_OVERHEAD >= DROP_NOTICE_LENGTH + LogSink::FRAME_OVERHEAD, "Drop notice must fit the overhead");
+    frames.reserve(this->capacity);
+}
+
+size_t Logging::DiagnosticsBuffer::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t Logging::DiagnosticsBuffer::write(const uint8_t *buffer, size_t size) {
+    std::lock_guard<std::mutex> lg(framesMutex);
+    if (frames.size() + size > capacity) {
+        dropped++;
+        return 0;
+    }
+    if (frames.empty()) {
+        pendingSince = millis();
+    }
+    frames.append(reinterpret_cast<const char *>(buffer), size);
+    return size;
+}
+
+bool Logging::DiagnosticsBuffer::isReady(uint32_t nowMs) {
+    std::lock_guard<std::mutex> lg(framesMutex);
+    // a frame was dropped when the buffer is full, frames rarely fill it up to `batchSize` exactly
+    if (frames.empty() || (frames.size() < batchSize && dropped == 0 && nowMs - pendingSince < batchAge)) {
+        return false;
+    }
+    refill(nowMs);
+    return frames.size() + BATCH_OVERHEAD <= tokens;
+}
+
+std::string Logging::DiagnosticsBuffer::peekBatch(uint32_t nowMs) {
+    std::string batch;
+    batch.reserve(capacity + BATCH_OVERHEAD);
+    std::lock_guard<std::mutex> lg(framesMutex);
+    batch = frames;
+    peekedFrames = frames.size();
+    peekedDropped = dropped;
+    if (dropped > 0) {
+        uint8_t notice[DROP_NOTICE_LENGTH];
+        buildDropNotice(notice, dropped, DROPPED_BUFFER_FULL, nowMs);
+        LogSink::appendFrame(batch, notice, DROP_NOTICE_LENGTH, LogSink::checksum(notice, DROP_NOTICE_LENGTH));
+    }
+    peekedSize = batch.size();
+    return batch;
+}
+
+void Logging::DiagnosticsBuffer::commitBatch(uint32_t nowMs) {
+    std::lock_guard<std::mutex> lg(framesMutex);
+    frames.erase(0, peekedFrames);
+    if (!frames.empty()) {
+        pendingSince = nowMs; // written while the batch was published
+    }
+    dropped -= peekedDropped;
+    refill(nowMs);
+    tokens -= std::min(tokens, (uint32_t) peekedSize);
+    peekedFrames = peekedSize = 0;
+    peekedDropped = 0;
+}
+
+void Logging::DiagnosticsBuffer::refill(uint32_t nowMs) {
+    uint64_t refill = (uint64_t) (nowMs - lastRefill) * bytesPerHour / 3600000;
+    if (refill > 0) {
+        tokens = (uint32_t) std::min((uint64_t) bytesPerHour, tokens + refill);
+        lastRefill = nowMs;
+    }
+}
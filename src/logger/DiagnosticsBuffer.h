@@ -0,0 +1,73 @@
+#ifndef LOGGING_DIAGNOSTICSBUFFER_H
+#define LOGGING_DIAGNOSTICSBUFFER_H
+
+#include "Arduino.h"
+#include <mutex>
+#include <string>
+
+namespace Logging {
+    /**
+     * Log output collecting frames for remote diagnostics, the owner of the connection publishes them in batches.
+     *
+     * The buffer never blocks the logger: frames which do not fit are dropped and the number of them is reported
+     * in the next batch. Batches are limited by a budget in bytes per hour (token bucket, the budget is also the largest
+     * burst), so a chatty tracker cannot eat the data plan.
+     * */
+    class DiagnosticsBuffer : public Print {
+    public:
+        /**
+         * @param capacity the most bytes waiting for publishing
+         * @param maxBatch the largest batch the connection can publish at once, limits the capacity
+         * @param batchSize batch is ready when it has this many bytes...
+         * @param batchAge ...or when its oldest frame waits this long (ms)
+         * @param bytesPerHour budget of published bytes
+         * */
+        DiagnosticsBuffer(size_t capacity, size_t maxBatch, size_t batchSize, uint32_t batchAge,
+                          uint32_t bytesPerHour);
+
+        size_t write(uint8_t c) override;
+
+        /**
+         * Stores the whole frame or nothing.
+         * */
+        size_t write(const uint8_t *buffer, size_t size) override;
+
+        /**
+         * @return true if a batch is ready and the budget allows to publish it
+         * */
+        bool isReady(uint32_t nowMs);
+
+        /**
+         * @return copy of the collected frames (and a notice of the dropped ones), they stay in the buffer until
+         * `commitBatch()`
+         * */
+        std::string peekBatch(uint32_t nowMs);
+
+        /**
+         * Removes the frames of the last `peekBatch()` and charges them to the budget, call once they were published.
+         * Frames written meanwhile stay for the next batch.
+         * */
+        void commitBatch(uint32_t nowMs);
+
+    private:
+        static constexpr size_t BATCH_OVERHEAD = 32; // drop notice frame
+
+        void refill(uint32_t nowMs);
+
+        size_t capacity;
+        size_t batchSize;
+        uint32_t batchAge;
+        uint32_t bytesPerHour;
+        uint32_t tokens;
+        uint32_t lastRefill = 0;
+        uint32_t pendingSince = 0;
+        uint32_t dropped = 0;
+        size_t peekedFrames = 0; // bytes of `frames` in the last peeked batch
+        size_t peekedSize = 0; // of the last peeked batch
+        uint32_t peekedDropped = 0; // reported in the last peeked batch
+        std::string frames;
+        std::mutex framesMutex;
+    };
+}
+
+#endif //LOGGING_DIAGNOSTICSBUFFER_H
@@ -0,0 +1,145 @@
+#include "FlightRecorder.h"
+#include <cstring>
+#include <esp_system.h>
+
+bool Logging::FlightRecorder::open() {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, PARTITION_SUBTYPE, "flightrec");
+    if (partition == nullptr) {
+        return false;
+    }
+    pageCount = partition->size / SECTOR_SIZE * PAGES_PER_SECTOR;
+    if (opened == nullptr) {
+        esp_register_shutdown_handler(flushOnShutdown);
+    }
+    opened = this;
+
+    // the newest sector is the one with the highest sequence on its first page
+    bool found = false;
+    uint32_t newestSector = 0;
+    PageHeader header{};
+    for (uint32_t sector = 0; sector < pageCount / PAGES_PER_SECTOR; sector++) {
+        if (readHeader(sector * PAGES_PER_SECTOR, header) && (!found || header.sequence > sequence)) {
+            found = true;
+            newestSector = sector;
+            sequence = header.sequence;
+        }
+    }
+    if (!found) {
+        nextPage = 0;
+        sequence = 0;
+        return true;
+    }
+
+    // continue after the last written page of the sector, or in the next sector when it is full
+    uint32_t first = newestSector * PAGES_PER_SECTOR;
+    nextPage = (first + PAGES_PER_SECTOR) % pageCount;
+    for (uint32_t p = first; p < first + PAGES_PER_SECTOR; p++) {
+        if (!readHeader(p, header)) {
+            nextPage = p;
+            break;
+        }
+        sequence = header.sequence;
+    }
+    sequence++;
+    return true;
+}
+
+size_t Logging::FlightRecorder::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t Logging::FlightRecorder::write(const uint8_t *buffer, size_t size) {
+    if (partition == nullptr) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lg(writeMutex);
+    size_t written = 0;
+    while (written < size) {
+        if (fill == 0) {
+            pendingSince = millis();
+        }
+        size_t chunk = std::min(size - written, PAGE_DATA - fill);
+        memcpy(page.data + fill, buffer + written, chunk);
+        fill += chunk;
+        written += chunk;
+        if (fill == PAGE_DATA) {
+            writePage();
+        }
+    }
+    return written;
+}
+
+void Logging::FlightRecorder::flush() {
+    std::lock_guard<std::mutex> lg(writeMutex);
+    writePage();
+}
+
+void Logging::FlightRecorder::flushStale() {
+    std::lock_guard<std::mutex> lg(writeMutex);
+    if (fill > 0 && millis() - pendingSince >= FLUSH_INTERVAL) {
+        writePage();
+    }
+}
+
+Logging::FlightRecorder::Cursor Logging::FlightRecorder::begin() const {
+    // the sector being written holds the newest pages, the one after it the oldest
+    uint32_t start = nextPage % PAGES_PER_SECTOR == 0
+                     ? nextPage
+                     : (nextPage / PAGES_PER_SECTOR + 1) * PAGES_PER_SECTOR % pageCount;
+    return {start, pageCount, 0, 0};
+}
+
+size_t Logging::FlightRecorder::read(Cursor &cursor, uint8_t *buffer, size_t maxLength) const {
+    size_t copied = 0;
+    while (copied < maxLength && cursor.remainingPages > 0) {
+        if (cursor.length == 0) {
+            PageHeader header{};
+            if (!readHeader(cursor.page, header) || header.length == 0) {
+                cursor.page = (cursor.page + 1) % pageCount;
+                cursor.remainingPages--;
+                continue;
+            }
+            cursor.length = header.length;
+            cursor.offset = 0;
+        }
+
+        size_t chunk = std::min((size_t) (cursor.length - cursor.offset), maxLength - copied);
+        size_t address = cursor.page * PAGE_SIZE + sizeof(PageHeader) + cursor.offset;
+        if (esp_partition_read(partition, address, buffer + copied, chunk) != ESP_OK) {
+            break;
+        }
+        copied += chunk;
+        cursor.offset += chunk;
+        if (cursor.offset == cursor.length) {
+            cursor.page = (cursor.page + 1) % pageCount;
+            cursor.remainingPages--;
+            cursor.length = 0;
+        }
+    }
+    return copied;
+}
+
+void Logging::FlightRecorder::flushOnShutdown() {
+    opened->flush();
+}
+
+bool Logging::FlightRecorder::readHeader(uint32_t p, PageHeader &header) const {
+    return esp_partition_read(partition, p * PAGE_SIZE, &header, sizeof(header)) == ESP_OK &&
+           header.magic == MAGIC && header.length <= PAGE_DATA;
+}
+
+void Logging::FlightRecorder::writePage() {
+    if (fill == 0) {
+        return;
+    }
+    if (nextPage % PAGES_PER_SECTOR == 0) {
+        esp_partition_erase_range(partition, nextPage * PAGE_SIZE, SECTOR_SIZE);
+    }
+    page.header = {sequence++, (uint16_t) fill, MAGIC};
+    memset(page.data + fill, 0xFF, PAGE_DATA - fill);
+    esp_partition_write(partition, nextPage * PAGE_SIZE, &page, PAGE_SIZE);
+    nextPage = (nextPage + 1) % pageCount;
+    fill = 0;
+}
+
+Logging::FlightRecorder *Logging::FlightRecorder::opened = nullptr;
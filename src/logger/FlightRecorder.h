@@ -0,0 +1,105 @@
+#ifndef LOGGING_FLIGHTRECORDER_H
+#define LOGGING_FLIGHTRECORDER_H
+
+#include "Arduino.h"
+#include <esp_partition.h>
+#include <mutex>
+
+namespace Logging {
+    /**
+     * Log output persisted in the `flightrec` flash partition, kept across resets and readable in service mode.
+     *
+     * The partition is a ring of 256 B pages, every page starts with a header carrying an increasing sequence number.
+     * Bytes are collected in RAM and written only as whole pages (a partial page is written by `flush()`), a 4 kB
+     * sector is erased right before its first page is written, so every sector is erased once per pass of the ring.
+     * On boot the writing continues after the newest page, the oldest sector is overwritten when the ring is full.
+     * */
+    class FlightRecorder : public Print {
+    public:
+        static constexpr esp_partition_subtype_t PARTITION_SUBTYPE = (esp_partition_subtype_t) 0x41;
+        static constexpr size_t PAGE_SIZE = 256;
+        static constexpr size_t SECTOR_SIZE = 4096;
+        static constexpr uint32_t FLUSH_INTERVAL = 10000; // ms, the longest time a partial page stays in RAM
+
+        struct PageHeader {
+            uint32_t sequence;
+            uint16_t length; // used bytes of the page data
+            uint16_t magic;
+        };
+
+        static constexpr size_t PAGE_DATA = PAGE_SIZE - sizeof(PageHeader);
+
+        /**
+         * Position of a reader, see `begin()` and `read()`.
+         * */
+        struct Cursor {
+            uint32_t page;
+            uint32_t remainingPages;
+            uint16_t offset;
+            uint16_t length; // of the current page, 0 if its header was not read yet
+        };
+
+        /**
+         * Finds the partition and the newest page. The collected bytes are flushed by `esp_restart()`.
+         *
+         * @return false if there is no `flightrec` partition
+         * */
+        bool open();
+
+        size_t write(uint8_t c) override;
+
+        size_t write(const uint8_t *buffer, size_t size) override;
+
+        /**
+         * Writes the collected bytes even if they do not fill the page.
+         * */
+        void flush();
+
+        /**
+         * Writes the collected bytes if the oldest of them waits longer than `FLUSH_INTERVAL`.
+         * */
+        void flushStale();
+
+        /**
+         * @return cursor at the oldest stored page
+         * */
+        [[nodiscard]] Cursor begin() const;
+
+        /**
+         * Copies stored data (without page headers) in the order they were written.
+         *
+         * @return number of bytes copied, 0 at the end
+         * */
+        size_t read(Cursor &cursor, uint8_t *buffer, size_t maxLength) const;
+
+    private:
+        static constexpr uint16_t MAGIC = 0x5246; // "FR"
+        static constexpr uint32_t PAGES_PER_SECTOR = SECTOR_SIZE / PAGE_SIZE;
+
+        struct Page {
+            PageHeader header;
+            uint8_t data[PAGE_DATA];
+        };
+
+        static_assert(sizeof(Page) == PAGE_SIZE, "Page must fill the flash page");
+
+        [[nodiscard]] bool readHeader(uint32_t page, PageHeader &header) const;
+
+        void writePage();
+
+        static void flushOnShutdown();
+
+        static FlightRecorder *opened; // the recorder flushed by the shutdown handler
+
+        const esp_partition_t *partition = nullptr;
+        uint32_t pageCount = 0;
+        uint32_t nextPage = 0;
+        uint32_t sequence = 0;
+        uint32_t pendingSince = 0;
+        Page page{};
+        size_t fill = 0;
+        std::mutex writeMutex;
+    };
+}
+
+#endif //LOGGING_FLIGHTRECORDER_H
@@ -0,0 +1,148 @@
+#ifndef LOGGING_LOGRECORD_H
+#define LOGGING_LOGRECORD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "Arduino.h"
+
+/**
+ * Binary log records, decoded on the host by `tools/logdecoder.py` (keep both in sync).
+ *
+ * A record is the header followed by typed arguments (1 byte type + value, no alignment). The format string is not
+ * stored, only its address in the firmware image; the decoder reads it from the ELF file. Strings which are not part
+ * of the image (e.g. `String::c_str()`) are copied into the record.
+ * */
+namespace Logging {
+    enum Level {
+        DEBUG, INFO, WARNING, ERROR
+    };
+
+    /**
+     * @return level named `name` ("debug", "info", "warning" or "error"), `fallback` for anything else
+     * */
+    inline Level levelFromString(const char *name, Level fallback) {
+        static const char *const NAMES[] = {"debug", "info", "warning", "error"};
+        for (int level = DEBUG; level <= ERROR; level++) {
+            if (name != nullptr && strcasecmp(name, NAMES[level]) == 0) return (Level) level;
+        }
+        return fallback;
+    }
+
+    static constexpr uint8_t RECORD_VERSION = 1;
+
+    enum RecordFlags : uint8_t {
+        FLAG_LITERAL = 0x01, // the message has no format specifiers
+        FLAG_NEWLINE = 0x02, // newline is appended
+        FLAG_INLINE_FORMAT = 0x04, // the format is the first (string) argument, `format` is 0
+        FLAG_DROPPED = 0x08 // arguments are the number of dropped records and `DropReason`
+    };
+
+    enum DropReason : uint8_t {
+        DROPPED_RING_FULL,
+        DROPPED_RATE_LIMIT,
+        DROPPED_BUFFER_FULL
+    };
+
+    enum ArgumentType : uint8_t {
+        ARG_INT32 = 'i',
+        ARG_UINT32 = 'u',
+        ARG_INT64 = 'q',
+        ARG_UINT64 = 'Q',
+        ARG_DOUBLE = 'd',
+        ARG_STRING = 's', // 1 byte length + characters (at most 255, no terminating zero)
+        ARG_POINTER = 'p'
+    };
+
+    struct RecordHeader {
+        uint16_t length; // whole record in bytes (multiple of 4), first word of the record commits it
+        uint8_t level;
+        uint8_t flags;
+        uint32_t timestamp; // ms since boot
+        uint32_t format; // address of the format string
+    };
+
+    static_assert(sizeof(RecordHeader) == 12, "RecordHeader must match tools/logdecoder.py");
+
+    static constexpr size_t MAX_STRING_LENGTH = 255;
+
+    inline size_t boundedLength(const char *string) {
+        return string == nullptr ? 0 : strnlen(string, MAX_STRING_LENGTH);
+    }
+
+    template<typename T>
+    struct dependent_false : std::false_type {
+    };
+
+    template<typename T>
+    size_t argumentSize(const T &value) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same<U, const char *>::value || std::is_same<U, char *>::value) {
+            return 2 + boundedLength(value);
+        } else if constexpr (std::is_same<U, String>::value || std::is_same<U, std::string>::value) {
+            return 2 + std::min((size_t) value.length(), MAX_STRING_LENGTH);
+        } else if constexpr (std::is_floating_point<U>::value) {
+            return 1 + sizeof(double);
+        } else if constexpr (std::is_integral<U>::value || std::is_enum<U>::value) {
+            return 1 + (sizeof(U) > 4 ? 8 : 4);
+        } else if constexpr (std::is_pointer<U>::value) {
+            return 1 + sizeof(uint32_t);
+        } else {
+            static_assert(dependent_false<U>::value, "Unsupported type of a log argument");
+            return 0;
+        }
+    }
+
+    inline uint8_t *encodeString(uint8_t *out, const char *string, size_t length) {
+        *out++ = ARG_STRING;
+        *out++ = (uint8_t) length;
+        memcpy(out, string, length);
+        return out + length;
+    }
+
+    template<typename V>
+    uint8_t *encodeValue(uint8_t *out, ArgumentType type, V value) {
+        *out++ = type;
+        memcpy(out, &value, sizeof(V));
+        return out + sizeof(V);
+    }
+
+    template<typename T>
+    uint8_t *encodeArgument(uint8_t *out, const T &value) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same<U, const char *>::value || std::is_same<U, char *>::value) {
+            return encodeString(out, value, boundedLength(value));
+        } else if constexpr (std::is_same<U, String>::value || std::is_same<U, std::string>::value) {
+            return encodeString(out, value.c_str(), std::min((size_t) value.length(), MAX_STRING_LENGTH));
+        } else if constexpr (std::is_floating_point<U>::value) {
+            return encodeValue(out, ARG_DOUBLE, (double) value);
+        } else if constexpr (std::is_enum<U>::value) {
+            return encodeValue(out, ARG_INT32, (int32_t) value);
+        } else if constexpr (std::is_integral<U>::value && sizeof(U) > 4) {
+            return std::is_signed<U>::value ? encodeValue(out, ARG_INT64, (int64_t) value)
+                                            : encodeValue(out, ARG_UINT64, (uint64_t) value);
+        } else if constexpr (std::is_integral<U>::value) {
+            return std::is_signed<U>::value ? encodeValue(out, ARG_INT32, (int32_t) value)
+                                            : encodeValue(out, ARG_UINT32, (uint32_t) value);
+        } else {
+            return encodeValue(out, ARG_POINTER, (uint32_t) (uintptr_t) value);
+        }
+    }
+
+    static constexpr size_t DROP_NOTICE_LENGTH = sizeof(RecordHeader) + 12;
+
+    /**
+     * Builds a record reporting dropped records into `record` (`DROP_NOTICE_LENGTH` bytes).
+     * */
+    inline void buildDropNotice(uint8_t *record, uint32_t dropped, DropReason reason, uint32_t timestamp) {
+        memset(record, 0, DROP_NOTICE_LENGTH);
+        auto *header = reinterpret_cast<RecordHeader *>(record);
+        *header = {(uint16_t) DROP_NOTICE_LENGTH, (uint8_t) WARNING, FLAG_DROPPED, timestamp, 0};
+        uint8_t *out = encodeArgument(record + sizeof(RecordHeader), dropped);
+        encodeArgument(out, (uint32_t) reason);
+    }
+}
+
+#endif //LOGGING_LOGRECORD_H
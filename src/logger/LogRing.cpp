@@ -0,0 +1,80 @@
+#include "LogRing.h"
+#include <cstring>
+
+static uint32_t *firstWord(const uint8_t *record) {
+    return reinterpret_cast<uint32_t *>(const_cast<uint8_t *>(record));
+}
+
+Logging::LogRing::LogRing(size_t capacity) :
+        storage(new uint32_t[capacity / sizeof(uint32_t)]()),
+        buffer(reinterpret_cast<uint8_t *>(storage.get())),
+        capacity((uint32_t) capacity),
+        mask((uint32_t) capacity - 1) {}
+
+uint8_t *Logging::LogRing::reserve(size_t length, bool *wake) {
+    uint32_t reserved = head.load(std::memory_order_relaxed);
+    for (;;) {
+        uint32_t released = tail.load(std::memory_order_acquire);
+        uint32_t offset = reserved & mask;
+        // the record does not fit before the end, padding takes the rest and the record starts at the beginning
+        uint32_t padding = offset + length > capacity ? capacity - offset : 0;
+        uint32_t needed = padding + (uint32_t) length;
+        if (reserved + needed - released > capacity) {
+            bool first = dropped.fetch_add(1, std::memory_order_relaxed) == 0;
+            if (wake != nullptr) *wake = first;
+            return nullptr;
+        }
+        if (head.compare_exchange_weak(reserved, reserved + needed, std::memory_order_acq_rel,
+                                       std::memory_order_relaxed)) {
+            if (padding > 0) {
+                commit(buffer + offset, (uint16_t) padding, PADDING);
+            }
+            // the consumer finding a record which is not committed yet does not wait for it long (see `isEmpty()`)
+            if (wake != nullptr) *wake = reserved == released;
+            return buffer + ((reserved + padding) & mask);
+        }
+    }
+}
+
+void Logging::LogRing::commit(uint8_t *record, uint16_t length, uint16_t userBits) {
+    __atomic_store_n(firstWord(record), (uint32_t) length | (uint32_t) userBits << 16, __ATOMIC_RELEASE);
+}
+
+const uint8_t *Logging::LogRing::peek() {
+    for (;;) {
+        uint32_t released = tail.load(std::memory_order_relaxed);
+        if (released == head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        const uint8_t *record = buffer + (released & mask);
+        uint32_t word = __atomic_load_n(firstWord(record), __ATOMIC_ACQUIRE);
+        if (word == 0) {
+            return nullptr; // reserved, but the producer is still writing
+        }
+        if ((word >> 16) != PADDING) {
+            return record;
+        }
+        release();
+    }
+}
+
+void Logging::LogRing::release() {
+    uint32_t released = tail.load(std::memory_order_relaxed);
+    uint8_t *record = buffer + (released & mask);
+    uint16_t length = lengthOf(record);
+    // a later record may start anywhere in this one, its first word must read 0 until it is committed
+    memset(record, 0, length);
+    tail.store(released + length, std::memory_order_release);
+}
+
+bool Logging::LogRing::isEmpty() const {
+    return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+}
+
+uint32_t Logging::LogRing::takeDropped() {
+    return dropped.exchange(0, std::memory_order_relaxed);
+}
+
+uint16_t Logging::LogRing::lengthOf(const uint8_t *record) {
+    return (uint16_t) (__atomic_load_n(firstWord(record), __ATOMIC_RELAXED) & 0xFFFF);
+}
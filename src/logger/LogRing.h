@@ -0,0 +1,79 @@
+#ifndef LOGGING_LOGRING_H
+#define LOGGING_LOGRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Logging {
+    /**
+     * Lock-free multi-producer, single-consumer ring of variable length records.
+     *
+     * Producers reserve space by a CAS on the head counter, fill the record and commit it by storing its first
+     * word last. The consumer takes committed records in the order of reservation and zeroes them when it is done,
+     * so the free space is all zeroes and a reserved record reads as uncommitted wherever it starts. Records never
+     * wrap around the end of the buffer, the rest of the buffer is skipped by a padding record instead. When the ring
+     * is full, the record is dropped and counted.
+     *
+     * Lengths are multiples of 4. The low 16 bits of the first word are the length of the record, the high 16 bits
+     * are free for the user (except 0xFFFF which marks padding).
+     * */
+    class LogRing {
+    public:
+        /**
+         * @param capacity in bytes, power of two (at most 64 kB)
+         * */
+        explicit LogRing(size_t capacity);
+
+        /**
+         * @param length length of the record in bytes (multiple of 4)
+         * @param wake set to true if the consumer may be waiting for this record (the ring was empty) or for the drop
+         * (the first one since `takeDropped()`), the producer wakes it up after the commit
+         * @return memory of the record or nullptr if the ring is full
+         * */
+        uint8_t *reserve(size_t length, bool *wake = nullptr);
+
+        /**
+         * Publishes the reserved record.
+         *
+         * @param userBits high 16 bits of the first word
+         * */
+        static void commit(uint8_t *record, uint16_t length, uint16_t userBits);
+
+        /**
+         * @return the oldest committed record or nullptr if there is none (or it is not committed yet)
+         * */
+        const uint8_t *peek();
+
+        /**
+         * Frees the record returned by `peek()`.
+         * */
+        void release();
+
+        /**
+         * @return true if nothing is reserved, false also when `peek()` returns nullptr for a record being written
+         * */
+        [[nodiscard]] bool isEmpty() const;
+
+        /**
+         * @return number of records dropped since the last call
+         * */
+        uint32_t takeDropped();
+
+        static uint16_t lengthOf(const uint8_t *record);
+
+    private:
+        static constexpr uint16_t PADDING = 0xFFFF;
+
+        std::unique_ptr<uint32_t[]> storage;
+        uint8_t *buffer;
+        uint32_t capacity;
+        uint32_t mask;
+        std::atomic<uint32_t> head{0}; // bytes reserved since start
+        std::atomic<uint32_t> tail{0}; // bytes released since start
+        std::atomic<uint32_t> dropped{0};
+    };
+}
+
+#endif //LOGGING_LOGRING_H
@@ -0,0 +1,94 @@
+#include "LogSink.h"
+
+Logging::LogSink::LogSink(Print *output, Level level, uint32_t bytesPerSecond, uint32_t burst) :
+        output(output),
+        level(level),
+        bytesPerSecond(bytesPerSecond),
+        burst(burst),
+        tokens(burst) {}
+
+void Logging::LogSink::write(const uint8_t *record, uint8_t checksum, uint32_t nowMs) {
+    auto *header = reinterpret_cast<const RecordHeader *>(record);
+    if (header->level < level) {
+        return;
+    }
+
+    reportDropped(nowMs);
+    if (!take(header->length + FRAME_OVERHEAD, nowMs)) {
+        dropped++;
+        unreported++;
+        return;
+    }
+    writeFrame(record, header->length, checksum);
+}
+
+void Logging::LogSink::flush(uint32_t nowMs) {
+    reportDropped(nowMs);
+}
+
+bool Logging::LogSink::hasUnreported() const {
+    return unreported > 0;
+}
+
+Logging::Level Logging::LogSink::getLevel() const {
+    return level;
+}
+
+void Logging::LogSink::setLevel(Level newLevel) {
+    level = newLevel;
+}
+
+const Print *Logging::LogSink::getOutput() const {
+    return output;
+}
+
+uint32_t Logging::LogSink::getDropped() const {
+    return dropped;
+}
+
+uint8_t Logging::LogSink::checksum(const uint8_t *record, size_t length) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < length; i++) {
+        sum += record[i];
+    }
+    return sum;
+}
+
+bool Logging::LogSink::take(size_t bytes, uint32_t nowMs) {
+    if (bytesPerSecond == 0) {
+        return true;
+    }
+    uint64_t refill = (uint64_t) (nowMs - lastRefill) * bytesPerSecond / 1000;
+    if (refill > 0) {
+        tokens = (uint32_t) std::min((uint64_t) burst, tokens + refill);
+        lastRefill = nowMs;
+    }
+    if (tokens < bytes) {
+        return false;
+    }
+    tokens -= bytes;
+    return true;
+}
+
+void Logging::LogSink::reportDropped(uint32_t nowMs) {
+    if (unreported == 0 || !take(DROP_NOTICE_LENGTH + FRAME_OVERHEAD, nowMs)) {
+        return;
+    }
+    uint8_t notice[DROP_NOTICE_LENGTH];
+    buildDropNotice(notice, unreported, DROPPED_RATE_LIMIT, nowMs);
+    writeFrame(notice, DROP_NOTICE_LENGTH, checksum(notice, DROP_NOTICE_LENGTH));
+    unreported = 0;
+}
+
+void Logging::LogSink::appendFrame(std::string &out, const uint8_t *record, size_t length, uint8_t checksum) {
+    out.push_back((char) FRAME_SYNC);
+    out.push_back((char) RECORD_VERSION);
+    out.append(reinterpret_cast<const char *>(record), length);
+    out.push_back((char) checksum);
+}
+
+void Logging::LogSink::writeFrame(const uint8_t *record, size_t length, uint8_t checksum) {
+    frame.clear();
+    appendFrame(frame, record, length, checksum);
+    output->write(reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+}
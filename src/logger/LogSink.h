@@ -0,0 +1,79 @@
+#ifndef LOGGING_LOGSINK_H
+#define LOGGING_LOGSINK_H
+
+#include "Arduino.h"
+#include <string>
+#include "LogRecord.h"
+
+namespace Logging {
+    /**
+     * Output of the logger with its own level and rate limit.
+     *
+     * Frames are written only by the logger's drain on the event loop. When the sink runs out of its byte budget
+     * (token bucket), frames are dropped instead of waiting, the number of dropped frames is reported once the budget
+     * allows it.
+     * */
+    class LogSink {
+    public:
+        /**
+         * @param bytesPerSecond sustained rate of the output, 0 means unlimited
+         * @param burst the most bytes written at once after a quiet period
+         * */
+        LogSink(Print *output, Level level, uint32_t bytesPerSecond, uint32_t burst);
+
+        /**
+         * Writes the record as a frame if its level passes and the budget allows it.
+         * */
+        void write(const uint8_t *record, uint8_t checksum, uint32_t nowMs);
+
+        /**
+         * Reports dropped frames even when no other record comes (called when the ring is empty).
+         * */
+        void flush(uint32_t nowMs);
+
+        /**
+         * @return true if dropped frames wait for the budget to be reported
+         * */
+        [[nodiscard]] bool hasUnreported() const;
+
+        [[nodiscard]] Level getLevel() const;
+
+        void setLevel(Level level);
+
+        [[nodiscard]] const Print *getOutput() const;
+
+        /**
+         * @return frames dropped by the rate limit since boot
+         * */
+        [[nodiscard]] uint32_t getDropped() const;
+
+        static uint8_t checksum(const uint8_t *record, size_t length);
+
+        /**
+         * Appends the record as a frame to `out`.
+         * */
+        static void appendFrame(std::string &out, const uint8_t *record, size_t length, uint8_t checksum);
+
+        static constexpr uint8_t FRAME_SYNC = 0xF5; // never part of UTF-8 text
+        static constexpr size_t FRAME_OVERHEAD = 3; // sync, version and checksum
+
+    private:
+        bool take(size_t bytes, uint32_t nowMs);
+
+        void reportDropped(uint32_t nowMs);
+
+        void writeFrame(const uint8_t *record, size_t length, uint8_t checksum);
+
+        Print *output;
+        Level level;
+        uint32_t bytesPerSecond;
+        uint32_t burst;
+        uint32_t tokens;
+        uint32_t lastRefill = 0;
+        uint32_t dropped = 0;
+        uint32_t unreported = 0;
+        std::string frame; // the frame is passed to the output by a single write
+    };
+}
+
+#endif //LOGGING_LOGSINK_H
@@ -0,0 +1,76 @@
+#include "Logger.h"
+
+Logging::Logger::Logger() {
+    drainEvent = DefaultEventLoop.onEvent([this] { drain(); });
+}
+
+void Logging::Logger::addSink(Print *output, Level level, uint32_t bytesPerSecond) {
+    std::lock_guard<std::mutex> lg(sinksMutex);
+    sinks.emplace_back(new LogSink(output, level, bytesPerSecond, BURST));
+    updateMinLevel();
+}
+
+void Logging::Logger::setLevel(const Print *output, Level level) {
+    std::lock_guard<std::mutex> lg(sinksMutex);
+    for (auto &sink: sinks) {
+        if (sink->getOutput() == output) sink->setLevel(level);
+    }
+    updateMinLevel();
+}
+
+void Logging::Logger::drain() {
+    const uint8_t *record;
+    while ((record = ring.peek()) != nullptr) {
+        writeToSinks(record, LogRing::lengthOf(record));
+        ring.release();
+    }
+
+    // reported after the records which were in the ring before the drop happened
+    uint32_t dropped = ring.takeDropped();
+    if (dropped > 0) {
+        uint8_t notice[DROP_NOTICE_LENGTH];
+        buildDropNotice(notice, dropped, DROPPED_RING_FULL, millis());
+        writeToSinks(notice, DROP_NOTICE_LENGTH);
+    }
+
+    uint32_t now = millis();
+    bool unreported = false;
+    {
+        std::lock_guard<std::mutex> lg(sinksMutex);
+        for (auto &sink: sinks) {
+            sink->flush(now);
+            unreported |= sink->hasUnreported();
+        }
+    }
+
+    if (!ring.isEmpty()) {
+        drainAfter(0); // a producer is still writing the next record, it woke nobody as the ring was not empty
+    } else if (unreported) {
+        drainAfter(FLUSH_PERIOD);
+    }
+}
+
+void Logging::Logger::drainAfter(uint32_t millis) {
+    if (retry != 0) DefaultEventLoop.cancel(retry);
+    retry = DefaultEventLoop.after(millis, [this] {
+        retry = 0;
+        drain();
+    });
+}
+
+void Logging::Logger::writeToSinks(const uint8_t *record, size_t length) {
+    uint8_t checksum = LogSink::checksum(record, length);
+    uint32_t now = millis();
+    std::lock_guard<std::mutex> lg(sinksMutex);
+    for (auto &sink: sinks) {
+        sink->write(record, checksum, now);
+    }
+}
+
+void Logging::Logger::updateMinLevel() {
+    int level = ERROR + 1;
+    for (auto &sink: sinks) {
+        level = std::min(level, (int) sink->getLevel());
+    }
+    minLevel.store(level, std::memory_order_relaxed);
+}
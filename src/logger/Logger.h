@@ -2,8 +2,17 @@
 #define LOGGING_LOGGER_H
 
 #include "Arduino.h"
-#include "Utils.h"
+#include "FS.h"
 #include <TelnetStream.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <soc/soc_memory_layout.h>
+#include "LogRecord.h"
+#include "LogRing.h"
+#include "LogSink.h"
+#include "EventLoop.h"
 
 namespace {
     class NullStream : public Print {
@@ -12,51 +21,76 @@ namespace {
             return 0;
         }
     };
-
-    class StreamSplitter : public Print {
-    public:
-        void addStream(Stream *newStream) {
-            streams.push_back(newStream);
-        }
-
-        size_t write(uint8_t uint8) override {
-            size_t writtenBytes = 0;
-            for (auto stream: streams) {
-                writtenBytes += stream->write(uint8);
-            }
-            return writtenBytes;
-        }
-
-//        void flush() override {
-//            for (auto stream: streams) {
-//                stream->flush();
-//            }
-//        }
-
-    private:
-        std::vector<Stream *> streams;
-    };
 }
 
-namespace Logging {
-    enum Level {
-        DEBUG, INFO, WARNING, ERROR
-    };
+/**
+ * The lowest level compiled into the firmware (0 = DEBUG ... 3 = ERROR), set per environment in `platformio.ini`.
+ * */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+/**
+ * Logging macros. Calls below `LOG_MIN_LEVEL` are removed by the compiler including their arguments, calls above it
+ * evaluate the arguments only if the level passes the runtime filter of the logger.
+ * */
+#define LOG_AT(logger, level, ...) \
+    do { if ((logger)->isEnabled(level)) (logger)->printf((level), __VA_ARGS__); } while (0)
+#define LOG_STATIC(logger, level, ...) \
+    do { if constexpr (Logging::isCompiled(level)) LOG_AT(logger, level, __VA_ARGS__); } while (0)
+#define LOG_DEBUG(logger, ...) LOG_STATIC(logger, Logging::DEBUG, __VA_ARGS__)
+#define LOG_INFO(logger, ...) LOG_STATIC(logger, Logging::INFO, __VA_ARGS__)
+#define LOG_WARNING(logger, ...) LOG_STATIC(logger, Logging::WARNING, __VA_ARGS__)
+#define LOG_ERROR(logger, ...) LOG_STATIC(logger, Logging::ERROR, __VA_ARGS__)
 
-    class Logger : public Print {
+namespace Logging {
+    constexpr bool isCompiled(Level level) {
+        return level >= LOG_MIN_LEVEL;
+    }
+
+    /**
+     * Deferred binary logger.
+     *
+     * Call sites only store the address of the format string and raw arguments into a lock-free ring
+     * (see `LogRecord.h`), nothing is formatted on the device and the caller never waits for an output.
+     * A handler on `DefaultEventLoop` signalled by the producers drains the ring into the sinks as binary frames,
+     * `tools/logdecoder.py` turns them into text on the host. Output which is not a frame (e.g. boot messages) passes
+     * through the decoder unchanged.
+     *
+     * Every sink has its own level and rate limit, so a slow sink (e.g. telnet) loses records instead of delaying
+     * the others (and the other callbacks of the loop). Records dropped by a full ring or by a sink are counted and
+     * reported.
+     * */
+    class Logger {
     public:
+        static constexpr size_t RING_CAPACITY = 4096;
+        static constexpr int FLUSH_PERIOD = 1000; // ms, drops waiting for the budget of a sink are retried this often
+
+        // bytes per second, below the real throughput so a burst cannot block the event loop for long
+        static constexpr uint32_t SERIAL_RATE = 8000; // 115200 Bd
+        static constexpr uint32_t TELNET_RATE = 4000;
+        static constexpr uint32_t FILE_RATE = 2000;
+        // a page (256 B) per 10 s at the worst, so the 128 kB partition keeps over an hour of continuous warnings
+        static constexpr uint32_t FLIGHT_RECORDER_RATE = 16;
+        static constexpr Level FLIGHT_RECORDER_LEVEL = WARNING;
+        static constexpr uint32_t BURST = 2048;
+
         static Logger *serialLogger(Level level = WARNING) {
-            return new Logger{&Serial, level};
+            auto logger = new Logger();
+            logger->addSink(&Serial, level, SERIAL_RATE);
+            return logger;
         }
 
         static Logger *nullLogger() {
-            return new Logger{new NullStream};
+            return new Logger();
         }
 
         static Logger *telnetLogger(Level level = WARNING) {
             auto telnetStream = new TelnetStreamClass(23);
             telnetStream->begin(23);
-            return new Logger{telnetStream, level};
+            auto logger = new Logger();
+            logger->addSink(telnetStream, level, TELNET_RATE);
+            return logger;
         }
 
         /**
@@ -65,17 +99,36 @@ namespace Logging {
         static Logger *serialAndTelnetLogger(Level level = WARNING) {
             auto telnetStream = new TelnetStreamClass(23);
             telnetStream->begin(23);
-            auto splitter = new StreamSplitter();
-            splitter->addStream(&Serial);
-            splitter->addStream(telnetStream);
-            return new Logger{splitter, level};
+            auto logger = new Logger();
+            logger->addSink(&Serial, level, SERIAL_RATE);
+            logger->addSink(telnetStream, level, TELNET_RATE);
+            return logger;
         }
 
         static Logger *fileLogger(File *file, Level level = WARNING) {
-            auto splitter = new StreamSplitter();
-            splitter->addStream(&Serial);
-            splitter->addStream(file);
-            return new Logger{splitter, level};
+            auto logger = new Logger();
+            logger->addSink(&Serial, level, SERIAL_RATE);
+            logger->addSink(file, level, FILE_RATE);
+            return logger;
+        }
+
+        /**
+         * Adds an output, records below `level` are not written to it.
+         *
+         * @param bytesPerSecond sustained rate of the output, 0 means unlimited
+         * */
+        void addSink(Print *output, Level level, uint32_t bytesPerSecond = 0);
+
+        /**
+         * Changes the level of the sink writing to `output` (e.g. on request from the server).
+         * */
+        void setLevel(const Print *output, Level level);
+
+        /**
+         * @return true if records of the level are compiled in and accepted by at least one sink
+         * */
+        [[nodiscard]] bool isEnabled(Level level) const {
+            return isCompiled(level) && level >= minLevel.load(std::memory_order_relaxed);
         }
 
         void print(Level level, const String &string) {
@@ -83,75 +136,78 @@ namespace Logging {
         }
 
         void print(Level level, const char *string) {
-            if (level >= minLevel)
-                logger->printf("%s %s", levelToString(level, tag).c_str(), string);
+            if (isEnabled(level))
+                log(level, FLAG_LITERAL, string);
         }
 
         void println(Level level, const String &string) {
-            if (level >= minLevel)
+            if (isEnabled(level))
                 println(level, string.c_str());
         }
 
         void println(Level level, const char *string) {
-            if (level >= minLevel) {
-                logger->printf("%s %s\n", levelToString(level, tag ).c_str(), string);
-//                logger->flush();
-            }
+            if (isEnabled(level))
+                log(level, FLAG_LITERAL | FLAG_NEWLINE, string);
         }
 
-        template<typename T, typename... Targs>
-        void printf(Level level, const char *format, T value, Targs... Fargs) {
-            if (level >= minLevel) {
-                logger->print(levelToString(level, tag) + ' ');
-                rec_printf(format, value, Fargs...);
-            }
+        /**
+         * Standard printf format specifiers, arguments are formatted by the host decoder.
+         * */
+        template<typename... Targs>
+        void printf(Level level, const char *format, const Targs &... args) {
+            if (isEnabled(level))
+                log(level, 0, format, args...);
         }
 
     private:
-        size_t write(uint8_t uint8) override {
-            return logger->write(uint8);
-        }
-
-        Logger(Print *logger) : logger(logger) {}
+        Logger();
+
+        template<typename... Targs>
+        void log(Level level, uint8_t flags, const char *format, const Targs &... args) {
+            // strings out of the firmware image (heap, stack) cannot be looked up by the decoder
+            bool inImage = esp_ptr_in_drom(format);
+            size_t length = sizeof(RecordHeader) + (inImage ? 0 : argumentSize(format)) +
+                            (argumentSize(args) + ... + 0);
+            size_t alignedLength = (length + 3) & ~(size_t) 3;
+            bool wake = false;
+            uint8_t *record = ring.reserve(alignedLength, &wake);
+            if (record == nullptr) {
+                if (wake) DefaultEventLoop.signal(drainEvent); // ring is full, the record is counted as dropped
+                return;
+            }
 
-        Logger(Print *logger, Level level) : logger(logger), minLevel(level) {}
+            uint8_t *out = record + sizeof(RecordHeader);
+            if (!inImage) {
+                out = encodeArgument(out, format);
+                flags |= FLAG_INLINE_FORMAT;
+            }
+            ((out = encodeArgument(out, args)), ...);
+            memset(out, 0, record + alignedLength - out); // type 0 ends the arguments
 
-        void rec_printf(const char *format) {
-            logger->print(format);
+            auto *header = reinterpret_cast<RecordHeader *>(record);
+            header->timestamp = millis();
+            header->format = inImage ? (uint32_t) (uintptr_t) format : 0;
+            LogRing::commit(record, alignedLength, level | flags << 8);
+            if (wake) DefaultEventLoop.signal(drainEvent);
         }
 
-        template<typename T, typename... Targs>
-        void rec_printf(const char *format, T value, Targs... Fargs) {
-            for (; *format != '\0'; format++) {
-                if (*format == '%') {
-                    format++;
-                    logger->print(value);
-                    rec_printf(format + 1, Fargs...);
-                    return;
-                }
-                logger->print(*format);
-            }
-//            logger->flush();
-        }
+        void drain();
 
-        static String levelToString(Level level, const String& prefix = "") {
-            switch (level) {
-                case DEBUG:
-                    return prefix + " [DBG]";
-                case INFO:
-                    return prefix + " [INFO]";
-                case WARNING:
-                    return prefix + " [WARN]";
-                case ERROR:
-                    return prefix + " [ERR]";
-                default:
-                    return prefix + " [???]";
-            }
-        }
+        /**
+         * Drains again after `millis` ms unless the producers signal earlier. Called on the loop.
+         * */
+        void drainAfter(uint32_t millis);
+
+        void writeToSinks(const uint8_t *record, size_t length);
+
+        void updateMinLevel(); // caller holds `sinksMutex`
 
-        String tag = Utils::randomString(8);
-        Print *logger;
-        Level minLevel;
+        LogRing ring{RING_CAPACITY};
+        EventBits_t drainEvent; // signalled when the ring becomes non-empty or starts dropping
+        EventLoop::TimerId retry = 0; // used only on the loop
+        std::vector<std::unique_ptr<LogSink>> sinks; // guarded by `sinksMutex`
+        std::mutex sinksMutex;
+        std::atomic<int> minLevel{ERROR + 1}; // the lowest level of all sinks
     };
 }
 
@@ -17,7 +17,8 @@ namespace MODEM {
         GPS_COORDINATES_OUT_OF_RANGE,
         SERIALIZATION_ERROR,
         SENDING_DATA_FAILED,
-        UNKNOWN_ERROR
+        UNKNOWN_ERROR,
+        GNSS_PARKED // no sample, GNSS is off until the parked heartbeat is due
     };
 
     class ISIM {
@@ -33,6 +34,11 @@ namespace MODEM {
         virtual STATUS_CODE wakeUp() = 0;
 
         virtual STATUS_CODE sendActPosition() = 0;
+
+        /**
+         * Parked tracker powers GNSS off and samples (and reports) only once per parked heartbeat.
+         * */
+        virtual void setParked(bool parked) = 0;
     };
 }
 #endif //LIGHTWEIGHT_GPS_TRACKER_ISIM_H
@@ -1,19 +1,36 @@
 #include "MqttClient.h"
 #include "HwLocks.h"
 
-void MqttClient::init(Configuration &config, Logging::Logger *log, Client *client) {
+void MqttClient::init(ConfigurationStore *configs, Logging::Logger *log, Client *client) {
     this->logger = log;
-    this->configuration = config;
+    this->configurations = configs;
     this->net = client;
 }
 
 bool MqttClient::begin() {
     if (connect()) {
-        DefaultTasker.loopEvery("mqtt", 100, [this] {
-            std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
-            if (!mqttClient.loop()) {
-                logger->println(Logging::WARNING, "MQTT loop returns false.");
+        // the poll waits for the modem (and handlers reload the configuration), only its schedule is on the loop
+        {
+            SerialGuard lg;
+            pollDue = xSemaphoreCreateBinary();
+            if (!modemSleeping) pollTimer = DefaultEventLoop.every(POLL_PERIOD, [this] { xSemaphoreGive(pollDue); });
+        }
+        DefaultTasker.loop("mqtt", [this] {
+            xSemaphoreTake(pollDue, portMAX_DELAY);
+            {
+                SerialGuard lg;
+                if (modemSleeping) return; // the tick came before the timer was cancelled
+                PowerLock::Guard tls(PowerManager::TLS);
+                if (!mqttClient.loop()) {
+                    LOG_WARNING(logger, "MQTT loop returns false.\n");
+                    if (mqttClient.lastError() == LWMQTT_BUFFER_TOO_SHORT) {
+                        LOG_ERROR(logger, "MQTT message larger than %d B dropped\n", READ_BUFFER);
+                        oversized = true;
+                    }
+                }
+                updateSession(mqttClient.connected());
             }
+            dispatch();
         });
         return true;
     }
@@ -21,45 +38,55 @@ bool MqttClient::begin() {
 }
 
 bool MqttClient::connect() {
-    logger->println(Logging::INFO, "Connecting to MQTT....");
-    mqttClient.begin(configuration.MQTT_CONFIG.host.c_str(), configuration.MQTT_CONFIG.port, *net);
-    mqttClient.setKeepAlive(configuration.CONFIG.sleepTime * uS_TO_S_FACTOR * 2);
+    LOG_INFO(logger, "Connecting to MQTT....\n");
+    connection = configurations->get();
+    mqttClient.begin(connection->MQTT_CONFIG.host.c_str(), connection->MQTT_CONFIG.port, *net);
+    mqttClient.setKeepAlive(connection->CONFIG.sleepTime * uS_TO_S_FACTOR * 2);
+    mqttClient.onMessage([this](String &topic, String &payload) {
+        // the client must not be used inside its callback
+        inbox.emplace_back(topic, payload);
+    });
 
     if (reconnect()) {
-        logger->println(Logging::INFO, "Modem connected to MQTT");
+        LOG_INFO(logger, "Modem connected to MQTT\n");
         return true;
     } else {
-        logger->println(Logging::ERROR, "Connecting to MQTT failed");
+        LOG_ERROR(logger, "Connecting to MQTT failed\n");
         return false;
     }
 }
 
 bool MqttClient::reconnect(int maxAttempts) {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+    SerialGuard lg;
+    PowerLock::Guard tls(PowerManager::TLS);
 
-    mqttClient.setHost(configuration.MQTT_CONFIG.host.c_str(), configuration.MQTT_CONFIG.port);
+    // a reloaded configuration takes effect with the next connection
+    connection = configurations->get();
+    const mqtt_config &mqttConfig = connection->MQTT_CONFIG;
+    mqttClient.setHost(mqttConfig.host.c_str(), mqttConfig.port);
 
     int errorAttempts = 0;
     while (!mqttClient.connected()) {
-        String clientId = "TRACKER-" + (String) configuration.CONFIG.trackerId;
+        String clientId = "TRACKER-" + (String) connection->CONFIG.trackerId;
         // Attempt to connect
-        logger->printf(Logging::INFO, "Attempting MQTT connection... host: %s, username: %s, password: %s\n",
-                       configuration.MQTT_CONFIG.host.c_str(),
-                       configuration.MQTT_CONFIG.username.c_str(), configuration.MQTT_CONFIG.password.c_str());
-        String willMessage = (String) configuration.CONFIG.trackerId + " is offline";
-        if (mqttClient.connect(clientId.c_str(),
-                               configuration.MQTT_CONFIG.username.c_str(),
-                               configuration.MQTT_CONFIG.password.c_str())) {
-            logger->printf(Logging::INFO, " connected to %s, topic: %s, username: %s, password: %s\n",
-                           configuration.MQTT_CONFIG.host.c_str(), configuration.MQTT_CONFIG.topic.c_str(),
-                           configuration.MQTT_CONFIG.username.c_str(), configuration.MQTT_CONFIG.password.c_str());
+        LOG_INFO(logger, "Attempting MQTT connection... host: %s, username: %s, password: %s\n",
+                 mqttConfig.host.c_str(), mqttConfig.username.c_str(), mqttConfig.password.c_str());
+        String willMessage = (String) connection->CONFIG.trackerId + " is offline";
+        if (mqttClient.connect(clientId.c_str(), mqttConfig.username.c_str(), mqttConfig.password.c_str())) {
+            LOG_INFO(logger, " connected to %s, topic: %s, username: %s, password: %s\n",
+                     mqttConfig.host.c_str(), mqttConfig.topic.c_str(),
+                     mqttConfig.username.c_str(), mqttConfig.password.c_str());
+            for (const auto &handler: handlers) {
+                mqttClient.subscribe(handler.first.c_str(), 1);
+            }
         } else {
             // connection failed
-            logger->printf(Logging::ERROR, "failed, try again in 5 seconds, attempt no. %d\n",
-                           errorAttempts);
+            LOG_ERROR(logger, "failed, try again in 5 seconds, attempt no. %d\n",
+                      errorAttempts);
             errorAttempts++;
             if (errorAttempts > maxAttempts) {
-                logger->println(Logging::ERROR, "MQTT connection error.");
+                LOG_ERROR(logger, "MQTT connection error.\n");
+                updateSession(false);
                 return false;
             }
             // Wait 5 seconds before retrying
@@ -67,47 +94,138 @@ bool MqttClient::reconnect(int maxAttempts) {
         }
     }
 
+    updateSession(true);
     return true;
 }
 
 bool MqttClient::isConnected() {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
-    return mqttClient.connected();
+    SerialGuard lg;
+    bool connected = mqttClient.connected();
+    updateSession(connected);
+    return connected;
 }
 
 bool MqttClient::sendString(const std::string &data) {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+    return publish(configurations->get()->MQTT_CONFIG.topic, data);
+}
+
+bool MqttClient::publish(const std::string &topic, const std::string &data) {
+    SerialGuard lg;
+    PowerLock::Guard tls(PowerManager::TLS);
 
-    logger->println(Logging::INFO, "Start sending routine...");
+    LOG_INFO(logger, "Start sending routine...\n");
     if (!isConnected()) {
-        logger->println(Logging::ERROR, "MQTT client error while sending data: %d\n");
+        LOG_ERROR(logger, "MQTT client is not connected, data were not sent\n");
         return false;
     }
 
-    bool published = mqttClient.publish(configuration.MQTT_CONFIG.topic.c_str(), data.c_str(), false, 1);
-    logger->printf(Logging::INFO, "Publish %d chars to MQTT topic %s ends with result: %d\n", data.length(),
-                   configuration.MQTT_CONFIG.topic.c_str(), published);
+    bool published = mqttClient.publish(topic.c_str(), data.data(), (int) data.length(), false, 1);
+    LOG_INFO(logger, "Publish %d chars to MQTT topic %s ends with result: %d\n", data.length(),
+             topic.c_str(), published);
+    if (published) sentBytes += data.length();
 
     return published;
 }
 
+size_t MqttClient::maxPayload(const std::string &topic) {
+    size_t overhead = PUBLISH_OVERHEAD + topic.length();
+    return WRITE_BUFFER > overhead ? WRITE_BUFFER - overhead : 0;
+}
+
+bool MqttClient::subscribe(const std::string &topic, MessageHandler handler) {
+    SerialGuard lg;
+    handlers[topic] = std::move(handler);
+    if (!isConnected()) {
+        return true; // subscribed on the next connection
+    }
+    bool subscribed = mqttClient.subscribe(topic.c_str(), 1);
+    LOG_INFO(logger, "Subscribe to MQTT topic %s ends with result: %d\n", topic.c_str(), subscribed);
+    return subscribed;
+}
+
+void MqttClient::onOversized(std::function<void(void)> handler) {
+    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+    oversizedHandler = std::move(handler);
+}
+
+size_t MqttClient::maxReceivedPayload(const std::string &topic) {
+    size_t overhead = PUBLISH_OVERHEAD + topic.length();
+    return READ_BUFFER > overhead ? READ_BUFFER - overhead : 0;
+}
+
+void MqttClient::dispatch() {
+    std::vector<std::pair<String, String>> received;
+    std::function<void(void)> notifyOversized;
+    {
+        std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+        received.swap(inbox);
+        if (oversized && mqttClient.connected()) {
+            oversized = false;
+            notifyOversized = oversizedHandler;
+        }
+    }
+    if (notifyOversized) notifyOversized();
+    for (const auto &message: received) {
+        MessageHandler handler;
+        {
+            std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+            auto it = handlers.find(message.first.c_str());
+            if (it != handlers.end()) handler = it->second;
+        }
+        if (handler) handler(message.second);
+    }
+}
+
 bool MqttClient::sendMessage(const Message &message) {
     std::string serializeMessage;
     if (!message.serialize(serializeMessage)) {
-        logger->println(Logging::ERROR, "Message serialization error");
+        LOG_ERROR(logger, "Message serialization error\n");
         return false;
     }
 
-    logger->printf(Logging::INFO, "Message: %s\n", serializeMessage.c_str());
+    LOG_INFO(logger, "Message: %s\n", serializeMessage.c_str());
 
     return sendString(serializeMessage);
 }
 
 bool MqttClient::sendData(JsonDocument *data) {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+    SerialGuard lg;
 
     std::string serialized;
     serializeJson(*data, serialized);
 
     return sendString(serialized);
 }
+
+unsigned long MqttClient::getSentBytes() const {
+    return sentBytes;
+}
+
+void MqttClient::setModemSleeping(bool sleeping) {
+    SerialGuard lg;
+    bool changed = sleeping != modemSleeping;
+    modemSleeping = sleeping;
+    updateSession(!sleeping && mqttClient.connected());
+    if (!changed || pollDue == nullptr) {
+        return;
+    }
+    if (sleeping) {
+        // the modem keeps received data until it wakes up, polling its UART would only wake the chip
+        DefaultEventLoop.cancel(pollTimer);
+    } else {
+        pollTimer = DefaultEventLoop.every(POLL_PERIOD, [this] { xSemaphoreGive(pollDue); });
+        xSemaphoreGive(pollDue); // data received during the sleep
+    }
+}
+
+void MqttClient::updateSession(bool connected) {
+    bool hold = connected && !modemSleeping;
+    if (hold == sessionHeld) return;
+    if (hold) {
+        PowerManager::MODEM.acquire();
+    } else {
+        PowerManager::MODEM.release();
+    }
+    sessionHeld = hold;
+    LOG_DEBUG(logger, "Light sleep %s by the MQTT session\n", hold ? "blocked" : "allowed");
+}
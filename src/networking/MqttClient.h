@@ -2,8 +2,11 @@
 #define LIGHTWEIGHT_GPS_TRACKER_MQTTCLIENT_H
 
 #include <MQTT.h>
+#include <map>
 #include <mutex>
-#include "Configuration.h"
+#include <vector>
+#include "ConfigurationStore.h"
+#include "EventLoop.h"
 #include "Tasker.h"
 #include "logger/Logger.h"
 #include "Protocol.h"
@@ -14,7 +17,9 @@ class MqttClient {
 public:
     MqttClient() {};
 
-    void init(Configuration &config, Logging::Logger *logger, Client *client);
+    typedef std::function<void(const String &payload)> MessageHandler;
+
+    void init(ConfigurationStore *configurations, Logging::Logger *logger, Client *client);
 
     bool begin();
 
@@ -28,10 +33,49 @@ public:
 
     bool sendString(const std::string &data);
 
+    /**
+     * Publishes `data` (may be binary) to the given topic (not the configured one).
+     * */
+    bool publish(const std::string &topic, const std::string &data);
+
+    /**
+     * @return the largest payload `publish()` can send to `topic` at once
+     * */
+    static size_t maxPayload(const std::string &topic);
+
+    /**
+     * Registers `handler` for messages on `topic`. Subscriptions are renewed after every reconnect.
+     * The handler is called from the MQTT task, outside of the client callback (so it may publish).
+     * */
+    bool subscribe(const std::string &topic, MessageHandler handler);
+
+    /**
+     * Registers `handler` for messages larger than `READ_BUFFER`. The client cannot receive them, it drops
+     * the connection instead (the message is lost). The handler is called from the MQTT task once the client
+     * is connected again.
+     * */
+    void onOversized(std::function<void(void)> handler);
+
+    /**
+     * @return the largest payload which can be received on `topic`
+     * */
+    static size_t maxReceivedPayload(const std::string &topic);
+
     bool sendMessage(const Message &message);
 
     bool sendData(JsonDocument *data);
 
+    /**
+     * @return number of payload bytes successfully published since boot
+     * */
+    [[nodiscard]] unsigned long getSentBytes() const;
+
+    /**
+     * Tells the client that the modem sleeps (UART off, received data wait in the modem) or is awake again.
+     * The poll stops while the modem sleeps.
+     * */
+    void setModemSleeping(bool sleeping);
+
 private:
     /**
      * Connects module to MQTT broker. Set necessary client information, initialize `mqttClient`.
@@ -43,10 +87,34 @@ private:
      * */
     bool connect();
 
-    MQTTClient mqttClient = MQTTClient(1024);
-    GPS_TRACKER::Configuration configuration;
+    void dispatch();
+
+    /**
+     * Holds `PowerManager::MODEM` while the session is connected and the modem is awake, so the chip does not
+     * light-sleep through downlinked bytes arriving on the UART. Called with `SERIAL_LOCK` held.
+     * */
+    void updateSession(bool connected);
+
+    static constexpr uint32_t POLL_PERIOD = 100; // ms
+    static constexpr int READ_BUFFER = 4096; // downlinked configuration may be bigger than reports (see README)
+    static constexpr int WRITE_BUFFER = 1024;
+    // fixed header (up to 5 B), topic length (2 B) and packet id (2 B) of a QoS 1 publish
+    static constexpr size_t PUBLISH_OVERHEAD = 9;
+
+    MQTTClient mqttClient = MQTTClient(READ_BUFFER, WRITE_BUFFER);
+    ConfigurationStore *configurations;
+    ConfigurationSnapshot connection; // configuration of the actual connection (host etc. must stay valid)
+    std::map<std::string, MessageHandler> handlers;
+    std::vector<std::pair<String, String>> inbox; // received in the client callback, dispatched after the loop
+    std::function<void(void)> oversizedHandler;
+    bool oversized = false; // a message did not fit, `oversizedHandler` is called after the reconnect
     Client *net;
     Logging::Logger *logger;
+    SemaphoreHandle_t pollDue = nullptr; // given by the poll timer on `DefaultEventLoop`
+    EventLoop::TimerId pollTimer = 0;
+    unsigned long sentBytes = 0;
+    bool sessionHeld = false; // `PowerManager::MODEM` is acquired for the session, guarded by `SERIAL_LOCK`
+    bool modemSleeping = false;
 };
 
 
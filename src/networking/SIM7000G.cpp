@@ -1,18 +1,31 @@
 #include "SIM7000G.h"
 #include "HwLocks.h"
+#include <tuple>
+
+GPS_TRACKER::SIM7000G::SIM7000G(Logging::Logger *logger, GPS_TRACKER::ConfigurationStore *configurations,
+                                GPS_TRACKER::StateManager *stateManager) :
+        logger(logger),
+        configurations(configurations),
+        stateManager(stateManager),
+        appliedConfiguration(configurations->get()),
+        positionFilter(positionFilterFor(*appliedConfiguration)),
+        trackSimplifier(trackSimplifierFor(*appliedConfiguration)) {}
 
 MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::init() {
-    logger->println(Logging::INFO, "Initializing SIM700G module...");
+    LOG_INFO(logger, "Initializing SIM700G module...\n");
+    ConfigurationSnapshot configuration = configurations->get();
 
-    if (configuration.GSM_CONFIG.enable) {
-        logger->println(Logging::INFO, "Connecting to GSM/MQTT");
+    if (configuration->GSM_CONFIG.enable) {
+        LOG_INFO(logger, "Connecting to GSM/MQTT\n");
         if (!connectGPRS()) return GSM_CONNECTION_ERROR;
-        mqttClient.init(configuration, logger, &gsmClientSSL);
+        mqttClient.init(configurations, logger, &gsmClientSSL);
         if (!mqttClient.begin()) return MQTT_CONNECTION_ERROR;
+        subscribeConfigurationUpdates();
+        initDiagnostics();
     }
 
-    if (configuration.GPS_CONFIG.enable) {
-        logger->println(Logging::INFO, "Enabling GPS (waiting for first fix)");
+    if (configuration->GPS_CONFIG.enable) {
+        LOG_INFO(logger, "Enabling GPS (waiting for first fix)\n");
         int failedConnection = 0;
         bool isGPSConnected = false;
         while (failedConnection < 4) {
@@ -23,16 +36,16 @@ MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::init() {
             }
         }
         if (!isGPSConnected) return GPS_CONNECTION_ERROR;
-        else logger->println(Logging::INFO, "Modem connected to GPS");
+        else LOG_INFO(logger, "Modem connected to GPS\n");
     }
     return Ok;
 }
 
 MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::actualPosition(GPSCoordinates *coordinates) {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+    SerialGuard lg;
     if (!isConnected()) {
 //        if (!reconnect()) {
-//            logger->println(Logging::WARNING, "Modem is not connected");
+//            LOG_WARNING(logger, "Modem is not connected\n");
 //        }
         return MODEM_NOT_CONNECTED;
     }
@@ -45,23 +58,35 @@ MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::actualPosition(GPSCoordinates *coordin
                      &rawTime.tm_mday, &rawTime.tm_hour, &rawTime.tm_min, &rawTime.tm_sec)) {
         // Position is out of range
         if (abs(lat) > 90 || abs(lon) > 180) {
-            logger->println(Logging::WARNING, "Invalid position read");
+            LOG_WARNING(logger, "Invalid position read\n");
             return GPS_COORDINATES_OUT_OF_RANGE;
         }
 
         time_t timestamp;
         time(&timestamp);
-        logger->printf(Logging::INFO, "lat: %f, lon: %f, alt: %f, acc: %f, timestamp: %l\n",
-                       lat, lon, alt, accuracy, timestamp);
+        LOG_INFO(logger, "lat: %f, lon: %f, alt: %f, acc: %f, timestamp: %ld\n",
+                 lat, lon, alt, accuracy, (long) timestamp);
+
+        // every fix is fused, the filter weights it by its HDOP and rejects outliers
+        unsigned long filterStart = micros();
+        GNSS::FILTER_RESULT filterResult = positionFilter.update(lat, lon, accuracy, millis());
+        LOG_DEBUG(logger, "Position filter update took %d us\n", micros() - filterStart);
+        if (filterResult == GNSS::REJECTED) {
+            LOG_WARNING(logger, "Fix rejected as an outlier (HDOP %f)\n", accuracy);
+            return GPS_ACCURACY_TOO_LOW;
+        }
 
-        // Accuracy is below the minimal threshold
-        if (accuracy > configuration.GPS_CONFIG.minimal_accuracy) {
-            logger->printf(Logging::WARNING, "Accuracy is too low: %f < %f\n", accuracy,
-                           configuration.GPS_CONFIG.minimal_accuracy);
+        // Accuracy of the estimate is below the minimal threshold
+        const gps_config &gpsConfig = appliedConfiguration->GPS_CONFIG;
+        double maxUncertainty = gpsConfig.minimal_accuracy * gpsConfig.uere;
+        if (positionFilter.accuracy() > maxUncertainty) {
+            LOG_WARNING(logger, "Accuracy is too low: %f > %f\n", positionFilter.accuracy(),
+                        maxUncertainty);
             return GPS_ACCURACY_TOO_LOW;
         }
 
-        *coordinates = GPSCoordinates(lat, lon, alt, timestamp);
+        *coordinates = GPSCoordinates(positionFilter.lat(), positionFilter.lon(), alt, timestamp,
+                                      positionFilter.speed(), usat);
 
         return Ok;
     }
@@ -70,24 +95,26 @@ MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::actualPosition(GPSCoordinates *coordin
 }
 
 bool GPS_TRACKER::SIM7000G::isConnected() {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
-    logger->printf(Logging::INFO, "is network connected: %b, is gprs connected %b\n", modem.isNetworkConnected(),
-                   modem.isGprsConnected());
-    return modem.isNetworkConnected() && modem.isGprsConnected();
+    SerialGuard lg;
+    // every call is an AT command round trip, the log line reuses the results
+    bool networkConnected = modem.isNetworkConnected();
+    bool gprsConnected = networkConnected && modem.isGprsConnected();
+    LOG_INFO(logger, "is network connected: %d, is gprs connected %d\n", networkConnected, gprsConnected);
+    return gprsConnected;
 }
 
 bool GPS_TRACKER::SIM7000G::connectGPRS() {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+    SerialGuard lg;
     wakeUp();
     SerialAT.begin(UART_BAUD, SERIAL_8N1, PIN_RX, PIN_TX);
 
     if (stateManager->getWakeupReason() != ESP_SLEEP_WAKEUP_TIMER) {
         if (!modem.restart()) {
-            logger->println(Logging::WARNING, "Failed to restart modem.");
+            LOG_WARNING(logger, "Failed to restart modem.\n");
         }
     }
 
-    logger->printf(Logging::INFO, "Modem: %s\n", modem.getModemInfo().c_str());
+    LOG_INFO(logger, "Modem: %s\n", modem.getModemInfo().c_str());
 
     /*
       2 Automatic
@@ -98,7 +125,7 @@ bool GPS_TRACKER::SIM7000G::connectGPRS() {
     String res;
     res = modem.setNetworkMode(13);
     if (!res) {
-        logger->println(Logging::ERROR, "setNetworkMode failed");
+        LOG_ERROR(logger, "setNetworkMode failed\n");
         return false;
     }
 
@@ -109,7 +136,7 @@ bool GPS_TRACKER::SIM7000G::connectGPRS() {
     * * */
     res = modem.setPreferredMode(1);
     if (!res) {
-        logger->println(Logging::ERROR, "setPreferredMode failed");
+        LOG_ERROR(logger, "setPreferredMode failed\n");
         return false;
     }
 
@@ -117,31 +144,31 @@ bool GPS_TRACKER::SIM7000G::connectGPRS() {
     int failedAttempts = 0;
     while (!modemConnectedSuccessfully) {
         if (failedAttempts > 3) {
-            logger->println(Logging::ERROR, "Connect to network failed! Hard reset may be needed.");
+            LOG_ERROR(logger, "Connect to network failed! Hard reset may be needed.\n");
             return false;
         }
-        logger->println(Logging::INFO, "Waiting for network...");
+        LOG_INFO(logger, "Waiting for network...\n");
         if (!modem.waitForNetwork(25000)) {
             failedAttempts++;
-            logger->println(Logging::ERROR, "Network connection failed!");
+            LOG_ERROR(logger, "Network connection failed!\n");
             continue;
         }
 
-        logger->printf(Logging::INFO, "Connecting to %s\n", configuration.GSM_CONFIG.apn.c_str());
-        if (!modem.gprsConnect(configuration.GSM_CONFIG.apn.c_str(),
-                               configuration.GSM_CONFIG.user.c_str(),
-                               configuration.GSM_CONFIG.password.c_str())) {
-            logger->println(Logging::ERROR, "GSM connection failed!");
+        ConfigurationSnapshot configuration = configurations->get();
+        const gsm_config &gsmConfig = configuration->GSM_CONFIG;
+        LOG_INFO(logger, "Connecting to %s\n", gsmConfig.apn.c_str());
+        if (!modem.gprsConnect(gsmConfig.apn.c_str(), gsmConfig.user.c_str(), gsmConfig.password.c_str())) {
+            LOG_ERROR(logger, "GSM connection failed!\n");
             continue;
         }
-        logger->println(Logging::INFO, "GSM connection succeeded!");
+        LOG_INFO(logger, "GSM connection succeeded!\n");
         modemConnectedSuccessfully = true;
     }
     return true;
 }
 
 bool GPS_TRACKER::SIM7000G::connectGPS() {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+    SerialGuard lg;
     wakeUp();
 
     modem.sendAT("+SGPIO=0,4,1,1");
@@ -151,52 +178,52 @@ bool GPS_TRACKER::SIM7000G::connectGPS() {
     }
 
     if (!modem.enableGPS()) {
-        logger->println(Logging::ERROR, "Enabling GPS failed");
+        LOG_ERROR(logger, "Enabling GPS failed\n");
         return false;
     }
 
     // update file for fast fix once for 2.5 days
-    logger->printf(Logging::INFO, "Time since last XTRA file update: %s\n",
-                   stateManager->getLastFastFixFileUpdate() - getActTime());
-    if (configuration.GPS_CONFIG.fastFix && stateManager->getLastFastFixFileUpdate() - getActTime() >= 216000) {
+    LOG_INFO(logger, "Time since last XTRA file update: %lu\n",
+             stateManager->getLastFastFixFileUpdate() - getActTime());
+    if (configurations->get()->GPS_CONFIG.fastFix && stateManager->getLastFastFixFileUpdate() - getActTime() >= 216000) {
         fastFix();
         stateManager->setLastFastFixFileUpdate(getActTime());
         coldStart();
     } else {
-        logger->println(Logging::INFO, "Skipping downloading of XTRA file");
+        LOG_INFO(logger, "Skipping downloading of XTRA file\n");
         hotStart();
     }
 
     float lat, lon, speed, alt, accuracy;
     int vsat, usat;
-    logger->println(Logging::INFO, "Waiting for GPS");
+    LOG_INFO(logger, "Waiting for GPS\n");
     while (!modem.getGPS(&lat, &lon, &speed, &alt, &vsat, &usat, &accuracy)) {
         if (this->isConnected()) {
-            logger->println(Logging::DEBUG, modem.getGPSraw());
-            logger->printf(Logging::DEBUG, "vsat: %d, usat: %d\n", vsat, usat);
+            LOG_DEBUG(logger, "%s\n", modem.getGPSraw());
+            LOG_DEBUG(logger, "vsat: %d, usat: %d\n", vsat, usat);
             Tasker::sleep(1500);
         } else {
             return false;
         }
     }
 
-    logger->println(Logging::INFO, "GPS successfully enabled");
+    LOG_INFO(logger, "GPS successfully enabled\n");
     return true;
 }
 
 bool GPS_TRACKER::SIM7000G::isGpsConnected() {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+    SerialGuard lg;
     float lat, lon;
     return modem.getGPS(&lat, &lon);
 }
 
 bool GPS_TRACKER::SIM7000G::reconnect() {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
-    logger->println(Logging::INFO, "Reconnecting");
+    SerialGuard lg;
+    LOG_INFO(logger, "Reconnecting\n");
     while (!isConnected() || !mqttClient.isConnected() || !isGpsConnected()) {
         wakeUp();
         if (!isConnected()) {
-            logger->println(Logging::INFO, "Reconnecting GPRS modem");
+            LOG_INFO(logger, "Reconnecting GPRS modem\n");
             if (!connectGPRS()) {
                 modem.sleepEnable(false);
                 modem.poweroff();
@@ -206,10 +233,10 @@ bool GPS_TRACKER::SIM7000G::reconnect() {
                 if (!mqttClient.reconnect(2)) return false;
             }
         } else {
-            logger->println(Logging::INFO, "GSM modem connected");
+            LOG_INFO(logger, "GSM modem connected\n");
         }
         if (!isGpsConnected()) {
-            logger->println(Logging::INFO, "Reconnecting GPS");
+            LOG_INFO(logger, "Reconnecting GPS\n");
             if (!connectGPS()) {
                 return false;
             }
@@ -217,23 +244,24 @@ bool GPS_TRACKER::SIM7000G::reconnect() {
             Serial.println("GPS modem connected");
         }
         if (!mqttClient.isConnected()) {
-            logger->println(Logging::INFO, "Reconnecting MQTT client");
+            LOG_INFO(logger, "Reconnecting MQTT client\n");
             if (!mqttClient.reconnect(2)) {
                 return false;
             }
         } else {
-            logger->println(Logging::INFO, "MQTT modem connected");
+            LOG_INFO(logger, "MQTT modem connected\n");
         }
     }
-    logger->println(Logging::INFO, "Reconnecting done");
+    LOG_INFO(logger, "Reconnecting done\n");
     return true;
 }
 
 void GPS_TRACKER::SIM7000G::fastFix() {
-    std::lock_guard<std::recursive_mutex> lg(HwLocks::SERIAL_LOCK);
+    SerialGuard lg;
+    PowerLock::Guard tls(PowerManager::TLS);
     modem.sendAT(GF("+CGNSMOD=1,1,1,1"));
     modem.waitResponse();
-    std::string cmd = "+SAPBR=3,1, \"APN\",\"" + configuration.GSM_CONFIG.apn + "\"";
+    std::string cmd = "+SAPBR=3,1, \"APN\",\"" + configurations->get()->GSM_CONFIG.apn + "\"";
     modem.sendAT(GF(cmd.c_str()));
     modem.waitResponse();
     modem.sendAT(GF("+SAPBR=1,1"));
@@ -257,19 +285,19 @@ void GPS_TRACKER::SIM7000G::fastFix() {
 }
 
 void GPS_TRACKER::SIM7000G::hotStart() {
-    logger->println(Logging::INFO, "GPS hot start");
+    LOG_INFO(logger, "GPS hot start\n");
     modem.sendAT(GF("+CGNSHOT"));
     modem.waitResponse();
 }
 
 void GPS_TRACKER::SIM7000G::warmStart() {
-    logger->println(Logging::INFO, "GPS warm start");
+    LOG_INFO(logger, "GPS warm start\n");
     modem.sendAT(GF("+CGNSWARM"));
     modem.waitResponse();
 }
 
 void GPS_TRACKER::SIM7000G::coldStart() {
-    logger->println(Logging::INFO, "GPS cold start");
+    LOG_INFO(logger, "GPS cold start\n");
     modem.sendAT(GF("+CGNSCOLD"));
     modem.waitResponse(5000L, GF("+CGNSXTRA: 0"), GF("+CGNSXTRA: 2"));
 }
@@ -291,6 +319,7 @@ GPS_TRACKER::Timestamp GPS_TRACKER::SIM7000G::getActTime() {
 }
 
 MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::sleep() {
+    mqttClient.setModemSleeping(true);
     bool res = modem.sleepEnable(true);
     pinMode(PIN_DTR, OUTPUT);
     digitalWrite(PIN_DTR, HIGH);
@@ -299,7 +328,7 @@ MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::sleep() {
 }
 
 MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::wakeUp() {
-    logger->println(Logging::INFO, "Waking up SIM7000G");
+    LOG_INFO(logger, "Waking up SIM7000G\n");
 
     // POWER ON GSM MODULE
     pinMode(PWR_PIN, OUTPUT);
@@ -311,23 +340,183 @@ MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::wakeUp() {
     digitalWrite(PIN_DTR, LOW);
     delay(80);
     bool res = modem.sleepEnable(false);
+    mqttClient.setModemSleeping(false);
     return res ? MODEM::STATUS_CODE::Ok : MODEM::STATUS_CODE::UNKNOWN_ERROR;
 }
 
 MODEM::STATUS_CODE GPS_TRACKER::SIM7000G::sendActPosition() {
+    if (parked && !gnssParked) {
+        // the sample before was still the same place, GNSS stays off until the next heartbeat
+        parkGNSS();
+        return GNSS_PARKED;
+    }
+    unsigned long heartbeat = (unsigned long) appliedConfiguration->MOTION_CONFIG.parkedHeartbeat * 1000;
+    if (gnssParked && millis() - gnssParkedAt < heartbeat) {
+        return GNSS_PARKED;
+    }
+    gnssParked = false; // powered on again by `reconnect()`
     if (!reconnect()) {
         return UNKNOWN_ERROR;
     }
+    updateConfiguration();
     GPSCoordinates coordinates;
     STATUS_CODE actPositionState = actualPosition(&coordinates);
     if (Ok != actPositionState) {
-        logger->printf(Logging::WARNING, "Position is not valid, skipping: %d\n", actPositionState);
+        LOG_WARNING(logger, "Position is not valid, skipping: %d\n", actPositionState);
         return actPositionState;
     }
     stateManager->updatePosition(coordinates);
-    Message message(configuration.CONFIG.trackerId, stateManager->getVisitedWaypoints(), coordinates,
-                    batteryPercentage());
-    return mqttClient.sendMessage(message) ? Ok : SENDING_DATA_FAILED;
+    samplesCount++;
+
+    // publish only points which change the reconstructed path (and every reached waypoint immediately)
+    GPSCoordinates reported;
+    size_t visitedWaypoints = stateManager->getVisitedWaypoints();
+    bool publish = trackSimplifier.add(coordinates, &reported);
+    if (!publish && visitedWaypoints != reportedWaypoints) {
+        if (!trackSimplifier.flush(&reported)) reported = coordinates;
+        publish = true;
+    }
+    if (!publish) {
+        LOG_DEBUG(logger, "Position report suppressed\n");
+        publishDiagnostics();
+        return Ok;
+    }
+
+    if (!report(reported, visitedWaypoints)) {
+        return SENDING_DATA_FAILED; // the simplifier proposes the point again with the next sample
+    }
+    publishDiagnostics();
+    return Ok;
+}
+
+bool GPS_TRACKER::SIM7000G::report(const GPSCoordinates &point, size_t visitedWaypoints) {
+    Message message(appliedConfiguration->CONFIG.trackerId, visitedWaypoints, point, batteryPercentage());
+    if (!mqttClient.sendMessage(message)) {
+        return false;
+    }
+    trackSimplifier.markPublished();
+    reportedWaypoints = visitedWaypoints;
+    reportsCount++;
+    LOG_INFO(logger, "Reports sent: %d of %d samples, %d bytes in total\n", reportsCount, samplesCount,
+             mqttClient.getSentBytes());
+    return true;
+}
+
+void GPS_TRACKER::SIM7000G::setParked(bool park) {
+    parked = park;
+    if (!park) gnssParked = false; // the next sample powers GNSS on again
+    trackSimplifier.setMaxSilence(park ? appliedConfiguration->MOTION_CONFIG.parkedHeartbeat
+                                       : appliedConfiguration->REPORT_CONFIG.maxSilence);
+    LOG_INFO(logger, "Tracker %s\n", park ? "parked" : "unparked");
+}
+
+static auto filterParameters(const GPS_TRACKER::gps_config &config) {
+    return std::tie(config.uere, config.processNoise, config.outlierGate, config.maxRejected);
+}
+
+// the heartbeat is changed in place (`setMaxSilence()`)
+static auto simplifierParameters(const GPS_TRACKER::report_config &config) {
+    return std::tie(config.tolerance, config.deadBand);
+}
+
+void GPS_TRACKER::SIM7000G::updateConfiguration() {
+    ConfigurationSnapshot actual = configurations->get();
+    if (actual == appliedConfiguration) {
+        return;
+    }
+    bool simplifierChanged = simplifierParameters(actual->REPORT_CONFIG) !=
+                             simplifierParameters(appliedConfiguration->REPORT_CONFIG);
+    GPSCoordinates pending;
+    if (simplifierChanged && trackSimplifier.flush(&pending) && !report(pending, reportedWaypoints)) {
+        // the pending samples are within the tolerance of the old path only, applied with the next sample
+        LOG_WARNING(logger, "Pending track not published, the new configuration waits\n");
+        return;
+    }
+
+    if (filterParameters(actual->GPS_CONFIG) != filterParameters(appliedConfiguration->GPS_CONFIG)) {
+        positionFilter = positionFilterFor(*actual);
+    }
+    if (simplifierChanged) {
+        trackSimplifier = trackSimplifierFor(*actual);
+    }
+    // the level set over `diagnostics/level` stays unless the configured one changes
+    if (diagnostics != nullptr && actual->DIAGNOSTICS_CONFIG.level != appliedConfiguration->DIAGNOSTICS_CONFIG.level) {
+        logger->setLevel(diagnostics, Logging::levelFromString(actual->DIAGNOSTICS_CONFIG.level.c_str(),
+                                                               Logging::WARNING));
+    }
+    appliedConfiguration = actual;
+    trackSimplifier.setMaxSilence(parked ? actual->MOTION_CONFIG.parkedHeartbeat : actual->REPORT_CONFIG.maxSilence);
+    LOG_INFO(logger, "New configuration applied\n");
+}
+
+GNSS::PositionFilter GPS_TRACKER::SIM7000G::positionFilterFor(const Configuration &configuration) {
+    const gps_config &gpsConfig = configuration.GPS_CONFIG;
+    return {gpsConfig.uere, gpsConfig.processNoise, gpsConfig.outlierGate, (uint8_t) gpsConfig.maxRejected};
+}
+
+GNSS::TrackSimplifier GPS_TRACKER::SIM7000G::trackSimplifierFor(const Configuration &configuration) {
+    const report_config &reportConfig = configuration.REPORT_CONFIG;
+    return {reportConfig.tolerance, reportConfig.deadBand, reportConfig.maxSilence};
+}
+
+void GPS_TRACKER::SIM7000G::subscribeConfigurationUpdates() {
+    std::string topic = trackerTopic("config");
+    mqttClient.subscribe(topic, [this, topic](const String &payload) {
+        CONFIGURATION_UPDATE result = payload.length() == 0
+                                      ? configurations->reload()
+                                      : configurations->update(payload.c_str(), payload.length());
+        LOG_AT(logger, result == CONFIGURATION_ACCEPTED ? Logging::INFO : Logging::WARNING,
+               "Configuration update (%d B): %s\n", payload.length(), ConfigurationStore::toString(result));
+        mqttClient.publish(topic + "/status", ConfigurationStore::toString(result));
+    });
+    // only configuration files come close to the read buffer
+    mqttClient.onOversized([this, topic] {
+        LOG_WARNING(logger, "Configuration update larger than %u B\n", MqttClient::maxReceivedPayload(topic));
+        mqttClient.publish(topic + "/status", ConfigurationStore::toString(CONFIGURATION_TOO_LARGE));
+    });
+}
+
+void GPS_TRACKER::SIM7000G::initDiagnostics() {
+    const diagnostics_config &config = appliedConfiguration->DIAGNOSTICS_CONFIG;
+    if (!config.enable) {
+        return;
+    }
+    size_t maxBatch = MqttClient::maxPayload(trackerTopic("diagnostics"));
+    diagnostics = new Logging::DiagnosticsBuffer(DIAGNOSTICS_CAPACITY, maxBatch, config.batchSize,
+                                                 config.batchAge * 1000, config.budget);
+    logger->addSink(diagnostics, Logging::levelFromString(config.level.c_str(), Logging::WARNING));
+
+    mqttClient.subscribe(trackerTopic("diagnostics/level"), [this](const String &payload) {
+        Logging::Level level = Logging::levelFromString(payload.c_str(), Logging::WARNING);
+        logger->setLevel(diagnostics, level);
+        LOG_WARNING(logger, "Diagnostics level changed to %d\n", level);
+    });
+}
+
+void GPS_TRACKER::SIM7000G::publishDiagnostics() {
+    if (diagnostics == nullptr || !diagnostics->isReady(millis())) {
+        return;
+    }
+    std::string batch = diagnostics->peekBatch(millis());
+    if (mqttClient.publish(trackerTopic("diagnostics"), batch)) {
+        diagnostics->commitBatch(millis());
+    } else {
+        LOG_WARNING(logger, "Diagnostics (%d B) were not sent, kept for the next report\n", batch.length());
+    }
+}
+
+std::string GPS_TRACKER::SIM7000G::trackerTopic(const std::string &suffix) const {
+    return appliedConfiguration->MQTT_CONFIG.topic + "/" + std::to_string(appliedConfiguration->CONFIG.trackerId) +
+           "/" + suffix;
+}
+
+void GPS_TRACKER::SIM7000G::parkGNSS() {
+    SerialGuard lg;
+    if (!modem.disableGPS()) {
+        LOG_WARNING(logger, "Disabling GPS failed\n");
+    }
+    gnssParked = true;
+    gnssParkedAt = millis();
 }
 
 void GPS_TRACKER::SIM7000G::powerOff() {
@@ -11,11 +11,14 @@
 #include <TinyGsmClient.h>
 #include "SSLClient.h"
 #include "Tasker.h"
-#include "Configuration.h"
+#include "ConfigurationStore.h"
 #include "StreamDebugger.h"
 #include "StateManager.h"
 #include "logger/Logger.h"
+#include "logger/DiagnosticsBuffer.h"
 #include "MqttClient.h"
+#include "gnss/PositionFilter.h"
+#include "gnss/TrackSimplifier.h"
 #include <ArduinoHttpClient.h>
 #include <mutex>
 
@@ -28,10 +31,8 @@ namespace GPS_TRACKER {
      * */
     class SIM7000G : public ISIM {
     public:
-        explicit SIM7000G(Logging::Logger *logger, GPS_TRACKER::Configuration &config,
-                          GPS_TRACKER::StateManager *stateManager) : logger(logger),
-                                                                     configuration(config),
-                                                                     stateManager(stateManager) {};
+        explicit SIM7000G(Logging::Logger *logger, GPS_TRACKER::ConfigurationStore *configurations,
+                          GPS_TRACKER::StateManager *stateManager);
 
         STATUS_CODE sendData(JsonDocument *data) override;
 
@@ -57,6 +58,8 @@ namespace GPS_TRACKER {
 
         MODEM::STATUS_CODE wakeUp() override;
 
+        void setParked(bool parked) override;
+
         void powerOff();
 
     private:
@@ -76,6 +79,46 @@ namespace GPS_TRACKER {
 
         bool reconnect();
 
+        /**
+         * Applies the actual configuration if it changed since the last call. Only the parts whose settings changed
+         * restart: the position filter, the track simplifier (its pending segment is published first) and the level
+         * of diagnostics.
+         * */
+        void updateConfiguration();
+
+        /**
+         * Publishes the point proposed by the track simplifier and confirms it.
+         * */
+        bool report(const GPSCoordinates &point, size_t visitedWaypoints);
+
+        static GNSS::PositionFilter positionFilterFor(const Configuration &configuration);
+
+        static GNSS::TrackSimplifier trackSimplifierFor(const Configuration &configuration);
+
+        /**
+         * Accepts whole configuration files on `<topic>/<tracker-id>/config`, an empty message reloads
+         * `config.json`. The result is published on `<topic>/<tracker-id>/config/status`.
+         * */
+        void subscribeConfigurationUpdates();
+
+        /**
+         * Sends logs to `<topic>/<tracker-id>/diagnostics` (binary frames, see `tools/logdecoder.py`).
+         * The level can be changed by publishing its name to `<topic>/<tracker-id>/diagnostics/level`.
+         * */
+        void initDiagnostics();
+
+        /**
+         * Publishes a batch of logs if one is ready. Called only after the position report, so it never delays it.
+         * */
+        void publishDiagnostics();
+
+        std::string trackerTopic(const std::string &suffix) const;
+
+        /**
+         * Powers GNSS off until the parked heartbeat is due, `reconnect()` then powers it on again (hot start).
+         * */
+        void parkGNSS();
+
         /**
          * Downloads XTRA file. Call this once ever every three days.
          * */
@@ -100,9 +143,20 @@ namespace GPS_TRACKER {
         SSLClient gsmClientSSL = SSLClient(&gsmClient);
         SSLClient gsmClientSSL1 = SSLClient(&gsmClient1);
         MqttClient mqttClient;
+        Logging::DiagnosticsBuffer *diagnostics = nullptr;
         HttpClient http = HttpClient(gsmClientSSL1, SERVER_NAME.c_str(), 443);
-        GPS_TRACKER::Configuration configuration;
+        GPS_TRACKER::ConfigurationStore *configurations;
         GPS_TRACKER::StateManager *stateManager;
+        GPS_TRACKER::ConfigurationSnapshot appliedConfiguration; // the one the filter and simplifier were built for
+        GNSS::PositionFilter positionFilter;
+        GNSS::TrackSimplifier trackSimplifier;
+        size_t reportedWaypoints = 0;
+        bool parked = false;
+        bool gnssParked = false; // GNSS is off, samples are skipped until the heartbeat
+        unsigned long gnssParkedAt = 0; // ms
+        unsigned long samplesCount = 0;
+        unsigned long reportsCount = 0;
+        static constexpr size_t DIAGNOSTICS_CAPACITY = 2048;
         double batteryFullyChargedLimit = 4200;
         double batteryDischargeVoltage = 2700;
     };
@@ -0,0 +1,137 @@
+#ifndef LIGHTWEIGHT_GPS_TRACKER_TEST_TRACKS_H
+#define LIGHTWEIGHT_GPS_TRACKER_TEST_TRACKS_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Protocol.h"
+
+/**
+ * Seeded tracks shared by the host suites. Positions are meters east (x) and north (y) of (LAT, LON).
+ * */
+namespace Tracks {
+    static constexpr double METERS_PER_DEG = 6378388 * M_PI / 180;
+    static constexpr double LAT = 50.08, LON = 14.42;
+
+    inline double metersPerDegLon() {
+        return METERS_PER_DEG * cos(LAT * M_PI / 180);
+    }
+
+    /**
+     * Deterministic generator of the tracks, the same tracks on every platform.
+     * */
+    class Random {
+    public:
+        explicit Random(uint32_t seed) : state(seed) {}
+
+        double uniform() {
+            state = state * 1664525u + 1013904223u;
+            return ((state >> 8) + 0.5) / 16777216.0;
+        }
+
+        double normal(double sigma) {
+            return sigma * sqrt(-2 * log(uniform())) * cos(2 * M_PI * uniform());
+        }
+
+    private:
+        uint32_t state;
+    };
+
+    struct Point {
+        double x, y;
+    };
+
+    struct Track {
+        std::vector<GPS_TRACKER::GPSCoordinates> samples;
+        std::vector<Point> truth; // the true position of every sample
+        std::vector<float> noise; // sigma of every sample per axis in meters
+        double x = 0, y = 0; // the actual true position
+
+        void sample(long timestamp, Random &random, double sigma) {
+            double lat = LAT + (y + random.normal(sigma)) / METERS_PER_DEG;
+            double lon = LON + (x + random.normal(sigma)) / metersPerDegLon();
+            samples.emplace_back((float) lat, (float) lon, 300.0f, timestamp);
+            truth.push_back({x, y});
+            noise.push_back((float) sigma);
+        }
+    };
+
+    /**
+     * Walking around a city block, a turn every minute or so, one sample per second.
+     * */
+    inline Track walk() {
+        Random random(1);
+        Track track;
+        double heading = 0;
+        for (long t = 0; t < 1800; t++) {
+            if (t % 67 == 0) heading += random.uniform() * M_PI - M_PI / 2;
+            track.x += 1.4 * cos(heading);
+            track.y += 1.4 * sin(heading);
+            track.sample(t, random, 2);
+        }
+        return track;
+    }
+
+    /**
+     * Driving on winding roads, a sample every 5 s.
+     * */
+    inline Track drive() {
+        Random random(2);
+        Track track;
+        double heading = 1;
+        for (long t = 0; t < 3600; t += 5) {
+            heading += 0.15 * sin(t / 200.0);
+            track.x += 5 * 14 * cos(heading);
+            track.y += 5 * 14 * sin(heading);
+            track.sample(t, random, 3);
+        }
+        return track;
+    }
+
+    /**
+     * Parked, a short walk 40 m away and straight back sampled every 10 s, parked again.
+     * */
+    inline Track outAndBack() {
+        Random random(3);
+        Track track;
+        long t = 0;
+        for (; t < 300; t += 10) track.sample(t, random, 1);
+        for (double distance: {20.0, 40.0}) {
+            track.x = distance;
+            track.sample(t, random, 1);
+            t += 10;
+        }
+        track.x = 0;
+        for (; t < 900; t += 10) track.sample(t, random, 1);
+        return track;
+    }
+
+    /**
+     * Straight at walking speed sampled every 30 s, turning when the heartbeat is due.
+     * */
+    inline Track corner() {
+        Random random(5);
+        Track track;
+        for (long t = 0; t <= 90; t += 30) {
+            track.x = t * 0.7;
+            track.sample(t, random, 1);
+        }
+        for (long t = 120; t <= 300; t += 30) {
+            track.y = (t - 90) * 0.7;
+            track.sample(t, random, 1);
+        }
+        return track;
+    }
+
+    /**
+     * Parked for an hour, the fixes jitter within the dead-band.
+     * */
+    inline Track parked() {
+        Random random(4);
+        Track track;
+        for (long t = 0; t < 3600; t += 20) track.sample(t, random, 2);
+        return track;
+    }
+}
+
+#endif //LIGHTWEIGHT_GPS_TRACKER_TEST_TRACKS_H
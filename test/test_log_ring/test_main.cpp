@@ -0,0 +1,239 @@
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "logger/LogRing.h"
+
+using Logging::LogRing;
+
+static void fill(uint8_t *record, size_t length, uint8_t value) {
+    memset(record + sizeof(uint32_t), value, length - sizeof(uint32_t));
+}
+
+static void put(LogRing &ring, uint16_t length, uint8_t value) {
+    uint8_t *record = ring.reserve(length);
+    TEST_ASSERT_NOT_NULL(record);
+    fill(record, length, value);
+    LogRing::commit(record, length, value);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_uncommitted_record_after_wrap_is_not_visible() {
+    LogRing ring(64);
+    for (int i = 0; i < 5; i++) {
+        put(ring, 12, 0xAB);
+        TEST_ASSERT_NOT_NULL(ring.peek());
+        ring.release();
+    }
+    put(ring, 16, 0xCD); // wraps, padding takes the last 4 bytes
+    const uint8_t *record = ring.peek();
+    TEST_ASSERT_NOT_NULL(record);
+    TEST_ASSERT_EQUAL(16, LogRing::lengthOf(record));
+    ring.release();
+
+    // starts in the middle of an older record, its bytes must not read as a committed header
+    uint8_t *pending = ring.reserve(8);
+    TEST_ASSERT_NOT_NULL(pending);
+    TEST_ASSERT_NULL(ring.peek());
+    LogRing::commit(pending, 8, 1);
+    record = ring.peek();
+    TEST_ASSERT_TRUE(record == pending);
+    TEST_ASSERT_EQUAL(8, LogRing::lengthOf(record));
+}
+
+void test_records_come_in_order_across_wraps() {
+    LogRing ring(256);
+    int written = 0, read = 0;
+    for (int round = 0; round < 1000; round++) {
+        // lengths 4 to 64, so records and padding land everywhere in the buffer
+        for (int i = 0; i < 3; i++, written++) {
+            put(ring, (uint16_t) (4 + 4 * ((round * 7 + i * 5) % 16)), (uint8_t) (written % 255 + 1));
+        }
+        for (int i = 0; i < 3; i++, read++) {
+            const uint8_t *record = ring.peek();
+            TEST_ASSERT_NOT_NULL(record);
+            uint16_t length = LogRing::lengthOf(record);
+            for (size_t b = sizeof(uint32_t); b < length; b++) {
+                TEST_ASSERT_EQUAL(read % 255 + 1, record[b]);
+            }
+            ring.release();
+        }
+        TEST_ASSERT_NULL(ring.peek());
+    }
+}
+
+void test_full_ring_drops_and_counts() {
+    LogRing ring(64);
+    put(ring, 32, 1);
+    put(ring, 32, 2);
+    TEST_ASSERT_NULL(ring.reserve(4));
+    TEST_ASSERT_EQUAL(1, ring.takeDropped());
+    TEST_ASSERT_EQUAL(0, ring.takeDropped());
+}
+
+void test_wake_on_first_record_and_first_drop() {
+    LogRing ring(64);
+    bool wake = false;
+    uint8_t *record = ring.reserve(16, &wake);
+    TEST_ASSERT_TRUE(wake);
+    LogRing::commit(record, 16, 1);
+    record = ring.reserve(16, &wake);
+    TEST_ASSERT_FALSE(wake);
+    LogRing::commit(record, 16, 1);
+    TEST_ASSERT_NOT_NULL(ring.peek());
+    ring.release();
+    record = ring.reserve(16, &wake); // the consumer has not caught up yet
+    TEST_ASSERT_FALSE(wake);
+    LogRing::commit(record, 16, 1);
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_NOT_NULL(ring.reserve(16, &wake)); // never committed
+        TEST_ASSERT_FALSE(wake);
+    }
+    TEST_ASSERT_FALSE(ring.isEmpty());
+    TEST_ASSERT_NULL(ring.reserve(16, &wake));
+    TEST_ASSERT_TRUE(wake);
+    TEST_ASSERT_NULL(ring.reserve(16, &wake));
+    TEST_ASSERT_FALSE(wake);
+    TEST_ASSERT_EQUAL(2, ring.takeDropped());
+    TEST_ASSERT_NULL(ring.reserve(16, &wake));
+    TEST_ASSERT_TRUE(wake);
+}
+
+/**
+ * The consumer sleeps until woken as `Logger` does, a record must never wait for the long timeout.
+ * */
+void test_woken_consumer_gets_every_record() {
+    static constexpr int PRODUCERS = 3;
+    static constexpr uint32_t RECORDS = 20000;
+    LogRing ring(256);
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool given = false;
+    std::atomic<int> running{PRODUCERS};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&] {
+            for (uint32_t i = 0; i < RECORDS; i++) {
+                bool wake = false;
+                uint8_t *record = ring.reserve(16, &wake);
+                if (record != nullptr) LogRing::commit(record, 16, 1);
+                if (wake) {
+                    std::lock_guard<std::mutex> lg(mutex);
+                    given = true;
+                    condition.notify_one();
+                }
+                if (i % 64 == 0) std::this_thread::yield();
+            }
+            running--;
+        });
+    }
+
+    uint32_t received = 0, missed = 0;
+    std::chrono::milliseconds timeout{1000};
+    while (running > 0 || !ring.isEmpty()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!condition.wait_for(lock, timeout, [&given] { return given; }) && timeout.count() > 1) {
+                missed += !ring.isEmpty(); // woken only by the timeout while something was waiting
+            }
+            given = false;
+        }
+        while (ring.peek() != nullptr) {
+            ring.release();
+            received++;
+        }
+        ring.takeDropped();
+        timeout = std::chrono::milliseconds(ring.isEmpty() ? 1000 : 1);
+    }
+    for (std::thread &producer: producers) producer.join();
+    TEST_ASSERT_EQUAL(0, missed);
+    TEST_ASSERT_GREATER_THAN(0, received);
+}
+
+void test_concurrent_producers() {
+    static constexpr int PRODUCERS = 4;
+    static constexpr uint32_t RECORDS = 200000;
+    LogRing ring(1024);
+    std::atomic<int> running{PRODUCERS};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&ring, &running, p] {
+            for (uint32_t i = 0; i < RECORDS; i++) {
+                auto length = (uint16_t) (12 + 4 * (i % 8));
+                uint8_t *record = ring.reserve(length);
+                if (record == nullptr) continue;
+                memcpy(record + 4, &i, sizeof(i));
+                memset(record + 8, p, length - 8);
+                LogRing::commit(record, length, (uint16_t) p);
+            }
+            running--;
+        });
+    }
+
+    uint32_t received = 0;
+    int64_t last[PRODUCERS];
+    for (int64_t &l: last) l = -1;
+    for (;;) {
+        bool finished = running == 0; // read before the last peek, nothing is committed after it
+        const uint8_t *record = ring.peek();
+        if (record == nullptr) {
+            if (finished) break;
+            std::this_thread::yield();
+            continue;
+        }
+        uint16_t length = LogRing::lengthOf(record);
+        int p = record[2];
+        uint32_t i;
+        memcpy(&i, record + 4, sizeof(i));
+        TEST_ASSERT_LESS_THAN(PRODUCERS, p);
+        TEST_ASSERT_EQUAL(12 + 4 * (i % 8), length);
+        TEST_ASSERT_GREATER_THAN(last[p], (int64_t) i); // the records of a producer keep their order
+        for (size_t b = 8; b < length; b++) {
+            TEST_ASSERT_EQUAL(p, record[b]);
+        }
+        last[p] = i;
+        received++;
+        ring.release();
+    }
+    for (std::thread &producer: producers) producer.join();
+    TEST_ASSERT_EQUAL(PRODUCERS * RECORDS, received + ring.takeDropped());
+}
+
+void test_reserve_and_commit_cost() {
+    // what a log call pays, the consumer runs on the drain task
+    static constexpr int BATCH = 200, BATCHES = 5000;
+    LogRing ring(4096);
+    std::chrono::nanoseconds spent{0};
+    for (int batch = 0; batch < BATCHES; batch++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BATCH; i++) {
+            LogRing::commit(ring.reserve(16), 16, 0);
+        }
+        spent += std::chrono::steady_clock::now() - start;
+        while (ring.peek() != nullptr) ring.release();
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "reserve and commit of a 16 B record: %.1f ns",
+             (double) spent.count() / (BATCH * BATCHES));
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_uncommitted_record_after_wrap_is_not_visible);
+    RUN_TEST(test_records_come_in_order_across_wraps);
+    RUN_TEST(test_full_ring_drops_and_counts);
+    RUN_TEST(test_wake_on_first_record_and_first_drop);
+    RUN_TEST(test_woken_consumer_gets_every_record);
+    RUN_TEST(test_concurrent_producers);
+    RUN_TEST(test_reserve_and_commit_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,125 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "gnss/PositionFilter.h"
+#include "../Tracks.h"
+
+using GNSS::PositionFilter;
+using GPS_TRACKER::GPSCoordinates;
+using namespace Tracks;
+
+static constexpr float UERE = 4;
+static constexpr float PROCESS_NOISE = 1;
+static constexpr float GATE = 9.21;
+static constexpr uint8_t MAX_REJECTED = 5;
+static constexpr float QUANTIZATION = 1; // meters, latitude and longitude are floats
+
+struct Replay {
+    std::vector<GNSS::FILTER_RESULT> results;
+    std::vector<double> errors; // distance of the estimate from the true position in meters
+    std::vector<double> rawErrors; // distance of the fix from the true position in meters
+    std::vector<float> accuracies;
+};
+
+static double distance(float lat, float lon, const Point &truth) {
+    return hypot((lon - LON) * metersPerDegLon() - truth.x, (lat - LAT) * METERS_PER_DEG - truth.y);
+}
+
+/**
+ * Feeds the track as `SIM7000G::actualPosition` does, the HDOP of every fix matches its noise.
+ * */
+static Replay replay(const Track &track) {
+    PositionFilter filter(UERE, PROCESS_NOISE, GATE, MAX_REJECTED);
+    Replay result;
+    for (size_t i = 0; i < track.samples.size(); i++) {
+        const GPSCoordinates &sample = track.samples[i];
+        result.results.push_back(filter.update(sample.lat, sample.lon, track.noise[i] / UERE,
+                                               (uint32_t) sample.timestamp * 1000));
+        result.errors.push_back(distance(filter.lat(), filter.lon(), track.truth[i]));
+        result.rawErrors.push_back(distance(sample.lat, sample.lon, track.truth[i]));
+        result.accuracies.push_back(filter.accuracy());
+    }
+    return result;
+}
+
+static double rms(const std::vector<double> &values) {
+    double sum = 0;
+    for (double value: values) sum += value * value;
+    return sqrt(sum / (double) values.size());
+}
+
+/**
+ * The estimate is closer to the truth than the fixes and its reported accuracy holds (3 sigma, nearly always).
+ * */
+static void assertErrorBound(const Track &track, const Replay &replay, const char *name) {
+    size_t outside = 0, rejected = 0;
+    for (size_t i = 0; i < replay.errors.size(); i++) {
+        if (replay.errors[i] > 3 * replay.accuracies[i] + QUANTIZATION) outside++;
+        if (replay.results[i] == GNSS::REJECTED) rejected++;
+    }
+    char message[128];
+    snprintf(message, sizeof(message), "%s: %zu fixes, RMS error %.1f m (raw %.1f m), %zu outside 3 sigma, "
+             "%zu rejected", name, track.samples.size(), rms(replay.errors), rms(replay.rawErrors), outside, rejected);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(rms(replay.errors) < rms(replay.rawErrors), message);
+    TEST_ASSERT_TRUE_MESSAGE(outside <= track.samples.size() / 50, message);
+    TEST_ASSERT_TRUE_MESSAGE(rejected <= track.samples.size() / 50, message);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_walk() {
+    Track track = walk();
+    assertErrorBound(track, replay(track), "walk");
+}
+
+void test_drive() {
+    Track track = drive();
+    assertErrorBound(track, replay(track), "drive");
+}
+
+void test_outliers_are_rejected() {
+    Track track = walk();
+    std::vector<size_t> outliers;
+    for (size_t i = 100; i < track.samples.size(); i += 97) {
+        track.samples[i].lat += (float) (150 / METERS_PER_DEG); // multipath, 150 m off
+        outliers.push_back(i);
+    }
+    Replay result = replay(track);
+    for (size_t i: outliers) {
+        TEST_ASSERT_EQUAL(GNSS::REJECTED, result.results[i]);
+        TEST_ASSERT_LESS_THAN(3 * result.accuracies[i] + QUANTIZATION, result.errors[i]);
+    }
+}
+
+void test_restart_after_max_rejected() {
+    Track track = parked();
+    Random random(6);
+    size_t jump = track.samples.size();
+    track.x = 2000; // the receiver lost the signal and the tracker was moved meanwhile
+    long t = track.samples.back().timestamp;
+    for (int i = 1; i <= 10; i++) track.sample(t + 20 * i, random, 2);
+
+    Replay result = replay(track);
+    for (size_t i = jump; i < jump + MAX_REJECTED - 1; i++) {
+        TEST_ASSERT_EQUAL(GNSS::REJECTED, result.results[i]);
+        TEST_ASSERT_GREATER_THAN(1900, result.errors[i]); // stays at the old place
+    }
+    TEST_ASSERT_EQUAL(GNSS::INITIALIZED, result.results[jump + MAX_REJECTED - 1]);
+    for (size_t i = jump + MAX_REJECTED - 1; i < track.samples.size(); i++) {
+        TEST_ASSERT_NOT_EQUAL(GNSS::REJECTED, result.results[i]);
+        TEST_ASSERT_LESS_THAN(3 * result.accuracies[i] + QUANTIZATION, result.errors[i]);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_walk);
+    RUN_TEST(test_drive);
+    RUN_TEST(test_outliers_are_rejected);
+    RUN_TEST(test_restart_after_max_rejected);
+    return UNITY_END();
+}
@@ -0,0 +1,143 @@
+#include <unity.h>
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "SeqLock.h"
+
+struct Value {
+    static constexpr size_t WORDS = 16;
+    uint32_t words[WORDS];
+};
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_read_returns_the_last_write() {
+    SeqLock<Value> lock;
+    TEST_ASSERT_EQUAL(0, lock.read().words[0]);
+    lock.write([](Value &v) { v.words[3] = 7; });
+    lock.store(Value{{1}});
+    Value value = lock.read();
+    TEST_ASSERT_EQUAL(1, value.words[0]);
+    TEST_ASSERT_EQUAL(0, value.words[3]);
+}
+
+/**
+ * More readers and writers than cores, so writers get preempted in the middle of publishing. Every read must be
+ * a whole write and every reader must keep making progress.
+ * */
+void test_concurrent_reads_are_consistent() {
+    static constexpr int WRITERS = 2;
+    static constexpr uint32_t WRITES = 100000;
+    unsigned cores = std::thread::hardware_concurrency();
+    int readers = 2 * (int) (cores > 0 ? cores : 2);
+    SeqLock<Value> lock;
+    std::atomic<int> writing{WRITERS};
+    std::atomic<uint32_t> torn{0}, backwards{0};
+    std::vector<uint32_t> reads((size_t) readers, 0);
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; r++) {
+        threads.emplace_back([&lock, &writing, &torn, &backwards, &reads, r] {
+            uint32_t last = 0;
+            while (writing > 0) {
+                Value value = lock.read();
+                for (uint32_t word: value.words) {
+                    if (word != value.words[0]) torn++;
+                }
+                if (value.words[0] < last) backwards++;
+                last = value.words[0];
+                reads[r]++;
+            }
+        });
+    }
+    for (int w = 0; w < WRITERS; w++) {
+        threads.emplace_back([&lock, &writing] {
+            for (uint32_t i = 0; i < WRITES; i++) {
+                lock.write([](Value &v) {
+                    uint32_t next = v.words[0] + 1;
+                    for (uint32_t &word: v.words) word = next;
+                });
+            }
+            writing--;
+        });
+    }
+    for (std::thread &thread: threads) thread.join();
+
+    TEST_ASSERT_EQUAL(0, torn.load());
+    TEST_ASSERT_EQUAL(0, backwards.load());
+    TEST_ASSERT_EQUAL(WRITERS * WRITES, lock.read().words[Value::WORDS - 1]);
+    for (uint32_t count: reads) {
+        TEST_ASSERT_GREATER_THAN(0, count);
+    }
+}
+
+static bool setPriority(std::thread &thread, int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    return pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param) == 0;
+}
+
+/**
+ * FreeRTOS on one core: the reader has a higher priority than the writer and wakes up while the writer publishes.
+ * The writer never runs again unless the reader blocks.
+ * */
+void test_reader_preempting_writer_makes_progress() {
+    struct Large {
+        uint32_t words[1024]; // a long write, the reader often wakes up in the middle of it
+    };
+    static constexpr int READS = 2000;
+    cpu_set_t cpus, previous;
+    CPU_ZERO(&cpus);
+    CPU_SET(0, &cpus);
+    sched_getaffinity(0, sizeof(previous), &previous);
+    sched_setaffinity(0, sizeof(cpus), &cpus); // inherited by the threads
+
+    SeqLock<Large> lock;
+    std::atomic<bool> stop{false};
+    std::atomic<int> reads{0};
+    std::thread writer([&lock, &stop] {
+        while (!stop) {
+            lock.write([](Large &v) { v.words[0]++; });
+        }
+    });
+    std::thread reader([&lock, &stop, &reads] {
+        while (!stop && reads < READS) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50 + reads % 7 * 20));
+            (void) lock.read();
+            reads++;
+        }
+    });
+    bool realTime = setPriority(writer, 1) && setPriority(reader, 2);
+
+    // a spinning reader starves the writer, only the real-time throttling lets this thread check
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (reads < READS && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    int done = reads;
+    stop = true;
+    if (done < READS) {
+        // the reader cannot be stopped while it spins, the process exits with it
+        reader.detach();
+        writer.detach();
+    } else {
+        reader.join();
+        writer.join();
+    }
+    sched_setaffinity(0, sizeof(previous), &previous);
+    if (!realTime) TEST_IGNORE_MESSAGE("needs SCHED_FIFO (CAP_SYS_NICE)");
+    TEST_ASSERT_EQUAL(READS, done);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_read_returns_the_last_write);
+    RUN_TEST(test_concurrent_reads_are_consistent);
+    RUN_TEST(test_reader_preempting_writer_makes_progress);
+    return UNITY_END();
+}
@@ -0,0 +1,210 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "SleepScheduler.h"
+#include "../Tracks.h"
+
+using GPS_TRACKER::GPSCoordinates;
+using GPS_TRACKER::SleepScheduler;
+using GPS_TRACKER::config;
+using GPS_TRACKER::sleep_config;
+using namespace Tracks;
+
+static constexpr double FIX_NOISE = 3; // meters per axis
+
+/**
+ * A team moving east along a straight route, stages of constant speed one after another.
+ * */
+struct Team {
+    struct Stage {
+        double duration; // in seconds
+        double speed; // in m/s
+    };
+
+    std::vector<Stage> stages;
+
+    [[nodiscard]] double duration() const {
+        double total = 0;
+        for (const Stage &stage: stages) total += stage.duration;
+        return total;
+    }
+
+    [[nodiscard]] double position(double t) const {
+        double x = 0;
+        for (const Stage &stage: stages) {
+            if (t <= stage.duration) return x + t * stage.speed;
+            x += stage.duration * stage.speed;
+            t -= stage.duration;
+        }
+        return x;
+    }
+
+    [[nodiscard]] double speed(double t) const {
+        for (const Stage &stage: stages) {
+            if (t < stage.duration) return stage.speed;
+            t -= stage.duration;
+        }
+        return 0;
+    }
+};
+
+struct Result {
+    size_t waypoints = 0;
+    size_t missed = 0; // the team crossed the waypoint area but no fix was taken inside
+    size_t fixes = 0;
+    double awake = 0; // in seconds
+    double total = 0; // in seconds
+    size_t fastFixes = 0; // fixes of a tracker which never sleeps and samples at the fast rate
+};
+
+/**
+ * Replays the tracker loop: a fix, a decision of the scheduler, then a sleep (followed by the wake-up overhead
+ * needed for a fresh fix) or a wait for the next sample. The tracker is awake except for the sleeps, so the awake
+ * time stands for the energy (a light-sleeping tracker draws a small fraction of the awake current).
+ * */
+static Result replay(const Team &team, const std::vector<double> &waypoints, const config &generalConfig,
+                     const sleep_config &sleepConfig) {
+    Random random(7);
+    SleepScheduler scheduler;
+    Result result;
+    result.waypoints = waypoints.size();
+    result.total = team.duration();
+    result.fastFixes = (size_t) (result.total * 1000 / sleepConfig.fastSamplingRate);
+    size_t next = 0;
+    double t = 0;
+    while (t < result.total && next < waypoints.size()) {
+        double x = team.position(t) + random.normal(FIX_NOISE);
+        double y = random.normal(FIX_NOISE);
+        scheduler.addFix(GPSCoordinates((float) (LAT + y / METERS_PER_DEG), (float) (LON + x / metersPerDegLon()),
+                                        300.0f, (long) t, (float) team.speed(t)));
+        result.fixes++;
+
+        // the waypoint is visited if the fix is inside its area, it is missed once the team left the area behind
+        while (next < waypoints.size() && hypot(x - waypoints[next], y) <= generalConfig.accuracy) next++;
+        while (next < waypoints.size() && team.position(t) > waypoints[next] + generalConfig.accuracy) {
+            result.missed++;
+            next++;
+        }
+        if (next == waypoints.size()) break;
+
+        SleepScheduler::Plan plan = scheduler.plan(generalConfig, sleepConfig, hypot(x - waypoints[next], y));
+        if (plan.sleepTime > 0) {
+            t += (double) (plan.sleepTime + sleepConfig.wakeUpOverhead);
+            result.awake += (double) sleepConfig.wakeUpOverhead;
+        } else {
+            t += plan.samplingRate / 1000.0;
+            result.awake += plan.samplingRate / 1000.0;
+        }
+    }
+    result.awake += std::max(0.0, result.total - t); // the game is over, the tracker idles awake
+    return result;
+}
+
+static void report(const char *name, const Result &result) {
+    char message[160];
+    snprintf(message, sizeof(message), "%s: %zu/%zu waypoints missed, %zu fixes (%zu at the fast rate), "
+             "awake %.0f of %.0f s (%.0f %%)", name, result.missed, result.waypoints, result.fixes,
+             result.fastFixes, result.awake, result.total, 100 * result.awake / result.total);
+    TEST_MESSAGE(message);
+}
+
+/**
+ * A city game: waypoints 300 - 900 m apart, walking with running bursts and with stops between the waypoints (the team
+ * looks for the way or waits at crossings), the waypoints are crossed without stopping.
+ * */
+static Team cityGame(std::vector<double> &waypoints) {
+    Random random(8);
+    Team team;
+    double x = 0;
+    team.stages.push_back({60, 0});
+    for (int i = 0; i < 12; i++) {
+        double leg = 300 + 600 * random.uniform();
+        double running = random.uniform() < 0.5 ? 100 + 100 * random.uniform() : 0;
+        team.stages.push_back({(leg - running) / 2 / 1.4, 1.4});
+        team.stages.push_back({240 * random.uniform(), 0});
+        if (running > 0) team.stages.push_back({running / 4.0, 4.0});
+        team.stages.push_back({(leg - running) / 2 / 1.4, 1.4});
+        x += leg;
+        waypoints.push_back(x);
+    }
+    team.stages.push_back({60, 0});
+    return team;
+}
+
+/**
+ * A car rally: driving between villages 2 - 8 km apart, short stops at the waypoints.
+ * */
+static Team rally(std::vector<double> &waypoints) {
+    Random random(9);
+    Team team;
+    double x = 0;
+    for (int i = 0; i < 8; i++) {
+        double leg = 2000 + 6000 * random.uniform();
+        double speed = 10 + 10 * random.uniform();
+        team.stages.push_back({30 + 90 * random.uniform(), 0});
+        team.stages.push_back({leg / speed, speed});
+        x += leg;
+        waypoints.push_back(x);
+    }
+    team.stages.push_back({60, 0});
+    return team;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_city_game() {
+    std::vector<double> waypoints;
+    Team team = cityGame(waypoints);
+    Result result = replay(team, waypoints, config(1, "", 30, 300, 1), sleep_config());
+    report("city game", result);
+    TEST_ASSERT_EQUAL(0, result.missed);
+    TEST_ASSERT_LESS_THAN(result.total / 4, result.awake);
+}
+
+void test_rally() {
+    std::vector<double> waypoints;
+    Team team = rally(waypoints);
+    Result result = replay(team, waypoints, config(1, "", 100, 300, 1), sleep_config());
+    report("rally", result);
+    TEST_ASSERT_EQUAL(0, result.missed);
+    TEST_ASSERT_LESS_THAN(result.total / 4, result.awake);
+}
+
+/**
+ * Trusting the measured speed exactly, the tracker sleeps through the running bursts.
+ * */
+void test_no_safety_margin_misses_waypoints() {
+    std::vector<double> waypoints;
+    Team team = cityGame(waypoints);
+    Result result = replay(team, waypoints, config(1, "", 30, 300, 1), sleep_config(1, 0.5, 5, 3, 500, 2000));
+    report("city game without safety margin", result);
+    TEST_ASSERT_GREATER_THAN(0, result.missed);
+}
+
+/**
+ * A reloaded configuration applies with the next decision.
+ * */
+void test_plan_follows_the_given_configuration() {
+    SleepScheduler scheduler;
+    scheduler.addFix(GPSCoordinates((float) LAT, (float) LON, 300.0f, 0, 1));
+    SleepScheduler::Plan near = scheduler.plan(config(1, "", 100, 300, 1), sleep_config(), 1000);
+    SleepScheduler::Plan far = scheduler.plan(config(1, "", 100, 60, 1), sleep_config(4, 2, 5, 3, 500, 2000), 1000);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 2, near.speed);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 450, near.eta);
+    TEST_ASSERT_EQUAL(300, near.sleepTime);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 4, far.speed);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 225, far.eta);
+    TEST_ASSERT_EQUAL(60, far.sleepTime);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_city_game);
+    RUN_TEST(test_rally);
+    RUN_TEST(test_no_safety_margin_misses_waypoints);
+    RUN_TEST(test_plan_follows_the_given_configuration);
+    return UNITY_END();
+}
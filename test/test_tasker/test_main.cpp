@@ -0,0 +1,116 @@
+#include <unity.h>
+#include <atomic>
+#include <vector>
+#include "EventLoop.h"
+
+// all tests share the virtual clock and `DefaultEventLoop`, times are relative to the start of a test
+
+static int64_t nowMs() {
+    return HostClock::now() / 1000;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_sleep_follows_virtual_clock() {
+    int64_t start = nowMs();
+    std::vector<int64_t> wakeups; // written by the task, read once the clock settled
+    TaskHandle task = DefaultTasker.once("sleeper", [&wakeups] {
+        for (int i = 0; i < 3; i++) {
+            Tasker::sleep(250);
+            wakeups.push_back(nowMs());
+        }
+    });
+    HostClock::advance(1000 * 1000);
+    TEST_ASSERT_EQUAL(3, wakeups.size());
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT64(start + 250 * (i + 1), wakeups[i]);
+    }
+    TEST_ASSERT_FALSE(task->isRunning());
+}
+
+void test_loop_every() {
+    std::atomic<int> iterations{0};
+    TaskHandle task = DefaultTasker.loopEvery("periodic", 100, [&iterations] { iterations++; });
+    HostClock::advance(1050 * 1000);
+    task->cancel();
+    HostClock::advance(200 * 1000);
+    // the first iteration runs right away, each one then yields for 1 ms and sleeps 100 ms
+    TEST_ASSERT_EQUAL(11, iterations.load());
+    TEST_ASSERT_EQUAL(11, task->getIterations());
+    TEST_ASSERT_EQUAL_INT64(-1, task->getCpuTime()); // no run-time statistics on the host
+    TEST_ASSERT_FALSE(task->isRunning());
+}
+
+void test_after() {
+    int64_t start = nowMs();
+    int64_t firedAt = -1;
+    DefaultEventLoop.after(300, [&firedAt] { firedAt = nowMs(); });
+    HostClock::advance(299 * 1000);
+    TEST_ASSERT_EQUAL_INT64(-1, firedAt);
+    HostClock::advance(1000 * 1000);
+    TEST_ASSERT_EQUAL_INT64(start + 300, firedAt);
+}
+
+void test_every_and_cancel() {
+    std::atomic<int> fired{0};
+    EventLoop::TimerId timer = DefaultEventLoop.every(1000, [&fired] { fired++; });
+    HostClock::advance(60 * 1000 * 1000);
+    TEST_ASSERT_EQUAL(60, fired.load());
+    DefaultEventLoop.cancel(timer);
+    HostClock::advance(10 * 1000 * 1000);
+    TEST_ASSERT_EQUAL(60, fired.load());
+}
+
+void test_cancel_before_due() {
+    bool fired = false;
+    EventLoop::TimerId timer = DefaultEventLoop.after(500, [&fired] { fired = true; });
+    HostClock::advance(200 * 1000);
+    DefaultEventLoop.cancel(timer);
+    HostClock::advance(1000 * 1000);
+    TEST_ASSERT_FALSE(fired);
+}
+
+void test_cascade_is_not_delayed_by_lower_level() {
+    // the 800 ms timer is in the second level of the wheel, the later one in the first level must not hide it
+    int64_t start = nowMs();
+    int64_t firedAt = -1;
+    DefaultEventLoop.after(800, [&firedAt] { firedAt = nowMs(); });
+    DefaultEventLoop.after(500, [] {});
+    HostClock::advance(500 * 1000);
+    DefaultEventLoop.after(400, [] {});
+    HostClock::advance(1000 * 1000);
+    TEST_ASSERT_EQUAL_INT64(start + 800, firedAt);
+}
+
+void test_far_timer_cascades_from_the_top_level() {
+    int64_t start = nowMs();
+    int64_t firedAt = -1;
+    DefaultEventLoop.after(100 * 60 * 1000, [&firedAt] { firedAt = nowMs(); }); // beyond the range of the wheel
+    HostClock::advance(200 * 60 * 1000 * 1000LL);
+    TEST_ASSERT_EQUAL_INT64(start + 100 * 60 * 1000, firedAt);
+}
+
+void test_event_runs_handler() {
+    std::atomic<int> handled{0};
+    EventBits_t bit = DefaultEventLoop.onEvent([&handled] { handled++; });
+    TEST_ASSERT_NOT_EQUAL(0, bit);
+    DefaultEventLoop.signal(bit);
+    HostClock::settle();
+    TEST_ASSERT_EQUAL(1, handled.load());
+}
+
+int main() {
+    HostClock::useVirtualTime();
+    UNITY_BEGIN();
+    RUN_TEST(test_sleep_follows_virtual_clock);
+    RUN_TEST(test_loop_every);
+    RUN_TEST(test_after);
+    RUN_TEST(test_every_and_cancel);
+    RUN_TEST(test_cancel_before_due);
+    RUN_TEST(test_cascade_is_not_delayed_by_lower_level);
+    RUN_TEST(test_far_timer_cascades_from_the_top_level);
+    RUN_TEST(test_event_runs_handler);
+    return UNITY_END();
+}
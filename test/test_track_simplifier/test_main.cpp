@@ -0,0 +1,162 @@
+#include <unity.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "gnss/TrackSimplifier.h"
+#include "../Tracks.h"
+
+using GNSS::TrackSimplifier;
+using GPS_TRACKER::GPSCoordinates;
+using namespace Tracks;
+
+static constexpr float TOLERANCE = 8;
+static constexpr float DEAD_BAND = 5;
+static constexpr long MAX_SILENCE = 120;
+
+struct Replay {
+    std::vector<GPSCoordinates> published;
+    std::vector<long> publishedAt; // timestamp of the sample which triggered the publication
+};
+
+/**
+ * Feeds the track as `SIM7000G::sendActPosition` does, every `failEvery`-th report fails.
+ * */
+static Replay replay(const Track &track, int failEvery = 0) {
+    TrackSimplifier simplifier(TOLERANCE, DEAD_BAND, MAX_SILENCE);
+    Replay result;
+    int reports = 0;
+    GPSCoordinates point;
+    for (const GPSCoordinates &sample: track.samples) {
+        if (!simplifier.add(sample, &point)) continue;
+        reports++;
+        if (failEvery > 0 && reports % failEvery == 0) continue;
+        simplifier.markPublished();
+        result.published.push_back(point);
+        result.publishedAt.push_back(sample.timestamp);
+    }
+    if (simplifier.flush(&point)) {
+        simplifier.markPublished();
+        result.published.push_back(point);
+        result.publishedAt.push_back(track.samples.back().timestamp);
+    }
+    return result;
+}
+
+static double distanceToSegment(const GPSCoordinates &p, const GPSCoordinates &a, const GPSCoordinates &b) {
+    double metersPerDegLon = METERS_PER_DEG * cos(a.lat * M_PI / 180);
+    double px = (p.lon - a.lon) * metersPerDegLon, py = (p.lat - a.lat) * METERS_PER_DEG;
+    double ex = (b.lon - a.lon) * metersPerDegLon, ey = (b.lat - a.lat) * METERS_PER_DEG;
+    double lengthSquared = ex * ex + ey * ey;
+    double t = lengthSquared > 0 ? std::max(0.0, std::min(1.0, (px * ex + py * ey) / lengthSquared)) : 0;
+    return hypot(px - t * ex, py - t * ey);
+}
+
+/**
+ * Every sample lies within the tolerance (dead-band for the ignored ones) from the segment of the published points
+ * around it.
+ * */
+static void assertErrorBound(const Track &track, const Replay &replay, const char *name) {
+    const std::vector<GPSCoordinates> &published = replay.published;
+    TEST_ASSERT_GREATER_THAN(1, published.size());
+    TEST_ASSERT_EQUAL(track.samples.front().timestamp, published.front().timestamp);
+    double maxError = 0;
+    size_t segment = 0;
+    for (const GPSCoordinates &sample: track.samples) {
+        while (segment + 1 < published.size() && published[segment + 1].timestamp < sample.timestamp) segment++;
+        // the samples after the last published point were ignored, they are within the dead-band of it
+        const GPSCoordinates &end = published[std::min(segment + 1, published.size() - 1)];
+        double error = distanceToSegment(sample, published[segment], end);
+        maxError = std::max(maxError, error);
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "%s: %zu samples, %zu reports, max. error %.1f m",
+             name, track.samples.size(), published.size(), maxError);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(maxError <= std::max(TOLERANCE, DEAD_BAND) + 0.5, message);
+}
+
+static void assertHeartbeat(const Track &track, const Replay &replay) {
+    long interval = track.samples[1].timestamp - track.samples[0].timestamp;
+    for (size_t i = 1; i < replay.publishedAt.size(); i++) {
+        TEST_ASSERT_LESS_OR_EQUAL(MAX_SILENCE + interval, replay.publishedAt[i] - replay.publishedAt[i - 1]);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_walk() {
+    Track track = walk();
+    Replay result = replay(track);
+    assertErrorBound(track, result, "walk");
+    assertHeartbeat(track, result);
+    TEST_ASSERT_LESS_THAN(track.samples.size() / 5, result.published.size());
+}
+
+void test_drive() {
+    Track track = drive();
+    Replay result = replay(track);
+    assertErrorBound(track, result, "drive");
+    assertHeartbeat(track, result);
+}
+
+void test_out_and_back_excursion_is_published() {
+    Track track = outAndBack();
+    Replay result = replay(track);
+    assertErrorBound(track, result, "out and back");
+    bool turnaround = false;
+    for (const GPSCoordinates &point: result.published) {
+        turnaround |= distanceToSegment(point, track.samples[0], track.samples[0]) > 30;
+    }
+    TEST_ASSERT_TRUE(turnaround);
+}
+
+void test_heartbeat_keeps_the_segment_end() {
+    Track track = corner();
+    Replay result = replay(track);
+    assertErrorBound(track, result, "corner");
+    assertHeartbeat(track, result);
+}
+
+void test_parked_reports_only_heartbeats() {
+    Track track = parked();
+    Replay result = replay(track);
+    assertErrorBound(track, result, "parked");
+    assertHeartbeat(track, result);
+    TEST_ASSERT_LESS_OR_EQUAL(3600 / MAX_SILENCE + 2, result.published.size());
+}
+
+void test_failed_reports_keep_the_bound() {
+    Track tracks[] = {walk(), drive(), outAndBack(), corner(), parked()};
+    for (const Track &track: tracks) {
+        for (int failEvery: {2, 3}) {
+            assertErrorBound(track, replay(track, failEvery), "with failed reports");
+        }
+    }
+}
+
+void test_unconfirmed_point_is_proposed_again() {
+    TrackSimplifier simplifier(TOLERANCE, DEAD_BAND, MAX_SILENCE);
+    GPSCoordinates point;
+    TEST_ASSERT_TRUE(simplifier.add({50, 14, 0, 0}, &point));
+    TEST_ASSERT_TRUE(simplifier.add({50, 14, 0, 1}, &point)); // the first report failed, still no anchor
+    TEST_ASSERT_EQUAL(1, point.timestamp);
+    simplifier.markPublished();
+    TEST_ASSERT_FALSE(simplifier.add({50, 14, 0, 2}, &point)); // dead-band of the published point
+    TEST_ASSERT_FALSE(simplifier.flush(&point));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_walk);
+    RUN_TEST(test_drive);
+    RUN_TEST(test_out_and_back_excursion_is_published);
+    RUN_TEST(test_heartbeat_keeps_the_segment_end);
+    RUN_TEST(test_parked_reports_only_heartbeats);
+    RUN_TEST(test_failed_reports_keep_the_bound);
+    RUN_TEST(test_unconfirmed_point_is_proposed_again);
+    return UNITY_END();
+}
@@ -0,0 +1,138 @@
+#include <unity.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "WaypointReader.h"
+#include "Waypoints.h"
+
+using namespace GPS_TRACKER;
+
+/**
+ * In-memory stand-in of `File`, the part ArduinoJson and `WaypointReader` use.
+ * */
+class StringInput {
+public:
+    explicit StringInput(std::string content) : content(std::move(content)) {}
+
+    int read() {
+        return position < content.size() ? (uint8_t) content[position++] : -1;
+    }
+
+    int peek() const {
+        return position < content.size() ? (uint8_t) content[position] : -1;
+    }
+
+    size_t readBytes(char *buffer, size_t length) {
+        size_t copied = std::min(length, content.size() - position);
+        memcpy(buffer, content.data() + position, copied);
+        position += copied;
+        return copied;
+    }
+
+    void seek(size_t offset) {
+        position = offset;
+    }
+
+private:
+    std::string content;
+    size_t position = 0;
+};
+
+static std::vector<int> readIds(const std::string &json, bool *parsed = nullptr) {
+    StringInput input(json);
+    std::vector<int> ids;
+    bool result = WaypointReader::forEachWaypoint(input, [&ids](JsonObject v) {
+        ids.push_back(v["id"].as<int>());
+    });
+    if (parsed != nullptr) *parsed = result;
+    return ids;
+}
+
+/**
+ * A config like `data/config.json` with `count` waypoints on a few paths.
+ * */
+static std::string config(size_t count) {
+    std::string json = R"({"general": {"tracker-id": 1}, "mqtt": {"host": "example.com", "topic": "waypoints"},)"
+                       R"( "waypoints": [)";
+    char waypoint[128];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(waypoint, sizeof(waypoint), R"(%s{"id": %zu, "lat": %.7f, "lon": %.7f, "path": "/sounds/%zu.mp3"})",
+                 i == 0 ? "" : ", ", i + 1, 50.08 + i * 1e-4, 14.42 + i * 1e-4, i % 20);
+        json += waypoint;
+    }
+    return json + R"(], "audio": {"volume": 10}})";
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_waypoints_of_the_top_level_object_only() {
+    std::string json = R"({"general": {"name": "\"waypoints\": [{\"id\": 7}]"}, "note": "waypoints",)"
+                       R"( "nested": {"waypoints": [{"id": 8}]}, "list": [{"waypoints": [{"id": 9}]}],)"
+                       R"( "waypoints": [{"id": 1, "lat": 50, "lon": 14}, {"id": 2, "lat": 50, "lon": 14}]})";
+    std::vector<int> ids = readIds(json);
+    TEST_ASSERT_EQUAL(2, ids.size());
+    TEST_ASSERT_EQUAL(1, ids[0]);
+    TEST_ASSERT_EQUAL(2, ids[1]);
+}
+
+void test_missing_or_empty_waypoints() {
+    bool parsed = false;
+    TEST_ASSERT_EQUAL(0, readIds(R"({"general": {"waypoints": [{"id": 1}]}})", &parsed).size());
+    TEST_ASSERT_TRUE(parsed);
+    TEST_ASSERT_EQUAL(0, readIds(R"({"waypoints": [ ]})", &parsed).size());
+    TEST_ASSERT_TRUE(parsed);
+    TEST_ASSERT_EQUAL(0, readIds(R"({"waypoints": null})", &parsed).size());
+    TEST_ASSERT_TRUE(parsed);
+}
+
+void test_broken_element_fails() {
+    bool parsed = true;
+    readIds(R"({"waypoints": [{"id": 1}, {"id": ]})", &parsed);
+    TEST_ASSERT_FALSE(parsed);
+    readIds(R"({"waypoints": [{"id": 1} {"id": 2}]})", &parsed);
+    TEST_ASSERT_FALSE(parsed);
+}
+
+/**
+ * Both passes of `Configuration::readWaypoints` over a big game.
+ * */
+void test_read_5k_waypoints() {
+    static constexpr size_t COUNT = 5000;
+    StringInput input(config(COUNT));
+    auto start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    TEST_ASSERT_TRUE(WaypointReader::forEachWaypoint(input, [&count](JsonObject) { count++; }));
+    Waypoints waypoints;
+    waypoints.reserve(count);
+    bool stored = true;
+    input.seek(0);
+    TEST_ASSERT_TRUE(WaypointReader::forEachWaypoint(input, [&waypoints, &stored](JsonObject v) {
+        stored = waypoints.add(v["id"], v["lat"], v["lon"], v["path"] | "") && stored;
+    }));
+    auto spent = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    TEST_ASSERT_TRUE(stored);
+    TEST_ASSERT_EQUAL(COUNT, waypoints.size());
+    TEST_ASSERT_EQUAL(COUNT, waypoints.id(COUNT - 1));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 50.08 + (COUNT - 1) * 1e-4, waypoints.lat(COUNT - 1));
+    TEST_ASSERT_EQUAL_STRING("/sounds/19.mp3", waypoints.path(COUNT - 1));
+    char message[96];
+    snprintf(message, sizeof(message), "%zu waypoints read in %.1f ms (%.2f us per waypoint)", COUNT,
+             (double) spent.count() / 1000, (double) spent.count() / COUNT);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_waypoints_of_the_top_level_object_only);
+    RUN_TEST(test_missing_or_empty_waypoints);
+    RUN_TEST(test_broken_element_fails);
+    RUN_TEST(test_read_5k_waypoints);
+    return UNITY_END();
+}
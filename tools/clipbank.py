@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""
+Packs audio clips (MP3/WAV) into a single clip bank file which the tracker keeps open and seeks in.
+
+Layout (little endian):
+
+    header          magic "CLPB", uint16 version, uint16 count
+    index           `count` entries: uint32 offset, uint32 length, char name[24] (NUL terminated)
+    clips           the files as they are, each aligned to 4 bytes
+
+Clips are named by their file names. A waypoint path (e.g. "/moses.mp3") plays the clip of the same name,
+`Player::enqueueClips()` plays clips by their index (the order of the arguments, printed below) through the
+reserved name "#<index>:<name>", so names must not start with "#".
+Keep the clips out of data/, so they are not stored in SPIFFS twice.
+
+Usage:
+    python tools/clipbank.py data/clips.bin clips/*.mp3 clips/*.wav
+    pio run -t uploadfs
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"CLPB"
+VERSION = 1
+HEADER = struct.Struct("<4sHH")
+ENTRY = struct.Struct("<II24s")
+NAME_LENGTH = 24
+
+
+def align(size):
+    return (size + 3) & ~3
+
+
+def pack(clips):
+    """:return: the bank with the clips, given as (name, data) pairs"""
+    offset = align(HEADER.size + ENTRY.size * len(clips))
+    index = bytearray()
+    data = bytearray()
+    for name, content in clips:
+        index += ENTRY.pack(offset + len(data), len(content), name.encode())
+        data += content + b"\0" * (align(len(content)) - len(content))
+    bank = HEADER.pack(MAGIC, VERSION, len(clips)) + index
+    return bank + b"\0" * (align(len(bank)) - len(bank)) + data
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack audio clips into a clip bank")
+    parser.add_argument("output", help="clip bank file (e.g. data/clips.bin)")
+    parser.add_argument("clips", nargs="+", help="MP3/WAV clips, their order gives the indexes")
+    args = parser.parse_args()
+
+    clips = []
+    for path in args.clips:
+        name = os.path.basename(path)
+        if len(name.encode()) >= NAME_LENGTH:
+            sys.exit("Clip name %s is longer than %d bytes" % (name, NAME_LENGTH - 1))
+        if name.startswith("#"):
+            sys.exit("Clip name %s starts with the reserved '#'" % name)
+        if any(name == other for other, _ in clips):
+            sys.exit("Clip name %s is used twice" % name)
+        with open(path, "rb") as f:
+            clips.append((name, f.read()))
+    if len(clips) > 0xFFFF:
+        sys.exit("Too many clips")
+
+    bank = pack(clips)
+    with open(args.output, "wb") as f:
+        f.write(bank)
+    for i, (name, content) in enumerate(clips):
+        print("%5d %-24s %8d" % (i, name, len(content)))
+    print("%d clips, %d bytes" % (len(clips), len(bank)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""
+Re-encodes audio clips (data/*.mp3) into WAV files which the tracker plays without the MP3 decoder.
+
+    --bits 4    IMA ADPCM, 4 bits per sample (default)
+    --bits 8    unsigned 8-bit PCM
+    --bits 16   signed 16-bit PCM
+
+The clips are decoded by ffmpeg (must be on PATH) at the chosen rate, mono unless --stereo is given, and
+written next to the originals with the .wav extension (or into --output). The player chooses the decoder by
+the extension, so the waypoints in config.json must refer to the new files. A summary of the flash footprint
+of both sets is printed at the end.
+
+Usage:
+    python tools/convert_audio.py data/*.mp3
+    python tools/convert_audio.py --rate 16000 --bits 8 data/moses.mp3
+"""
+
+import argparse
+import array
+import os
+import struct
+import subprocess
+import sys
+
+FORMAT_PCM = 1
+FORMAT_IMA_ADPCM = 0x11
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+    107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871,
+    5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+    27086, 29794, 32767,
+]
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def decode(path, rate, channels):
+    """:return: interleaved signed 16-bit samples of the clip"""
+    command = ["ffmpeg", "-v", "error", "-i", path, "-f", "s16le", "-acodec", "pcm_s16le",
+               "-ar", str(rate), "-ac", str(channels), "-"]
+    samples = array.array("h", subprocess.run(command, check=True, stdout=subprocess.PIPE).stdout)
+    if sys.byteorder != "little":
+        samples.byteswap()
+    return samples
+
+
+class ImaChannel:
+    def __init__(self):
+        self.predictor = 0
+        self.index = 0
+
+    def encode(self, sample):
+        """:return: nibble of the sample, the state follows the decoder (src/audio/WavGenerator.cpp)"""
+        step = STEP_TABLE[self.index]
+        difference = sample - self.predictor
+        nibble = 0
+        if difference < 0:
+            nibble = 8
+            difference = -difference
+        for bit in (4, 2, 1):
+            if difference >= step:
+                nibble |= bit
+                difference -= step
+            step >>= 1
+
+        step = STEP_TABLE[self.index]
+        delta = step >> 3
+        if nibble & 1:
+            delta += step >> 2
+        if nibble & 2:
+            delta += step >> 1
+        if nibble & 4:
+            delta += step
+        self.predictor += -delta if nibble & 8 else delta
+        self.predictor = max(-32768, min(32767, self.predictor))
+        self.index = max(0, min(88, self.index + INDEX_TABLE[nibble]))
+        return nibble
+
+
+def encode_ima(samples, channels, block_size):
+    """
+    Encodes blocks of `block_size` bytes: a header (first sample, step index) of every channel followed by groups
+    of 4 bytes (8 samples) of every channel. The last block holds only the remaining groups.
+    """
+    group_samples = 8
+    samples_per_block = (block_size - 4 * channels) // (4 * channels) * group_samples + 1
+    frames = len(samples) // channels
+    states = [ImaChannel() for _ in range(channels)]
+    data = bytearray()
+    for start in range(0, frames, samples_per_block):
+        block = samples[start * channels:(start + samples_per_block) * channels]
+        for channel, state in enumerate(states):
+            state.predictor = block[channel]
+            data += struct.pack("<hBB", state.predictor, state.index, 0)
+        rest = block[channels:]
+        groups = -(-len(rest) // (channels * group_samples))
+        rest = rest + array.array("h", rest[-channels:] * (groups * group_samples - len(rest) // channels))
+        for group in range(groups):
+            for channel, state in enumerate(states):
+                first = (group * group_samples) * channels + channel
+                nibbles = [state.encode(rest[first + i * channels]) for i in range(group_samples)]
+                data += bytes(nibbles[i] | nibbles[i + 1] << 4 for i in range(0, group_samples, 2))
+    return data, samples_per_block
+
+
+def wav(samples, rate, channels, bits, block_size):
+    """:return: WAV file with the samples"""
+    extra = b""
+    fact = b""
+    if bits == 4:
+        data, samples_per_block = encode_ima(samples, channels, block_size)
+        fmt = struct.pack("<HHIIHH", FORMAT_IMA_ADPCM, channels, rate, rate * block_size // samples_per_block,
+                          block_size, 4)
+        extra = struct.pack("<HH", 2, samples_per_block)
+        fact = b"fact" + struct.pack("<II", 4, len(samples) // channels)
+    else:
+        if bits == 8:
+            data = bytes((sample >> 8) + 128 for sample in samples)
+        else:
+            data = samples.tobytes() if sys.byteorder == "little" else _swapped(samples)
+        fmt = struct.pack("<HHIIHH", FORMAT_PCM, channels, rate, rate * channels * bits // 8, channels * bits // 8,
+                          bits)
+    fmt += extra
+    chunks = b"fmt " + struct.pack("<I", len(fmt)) + fmt + fact + b"data" + struct.pack("<I", len(data)) + data
+    if len(data) % 2:
+        chunks += b"\0"
+    return b"RIFF" + struct.pack("<I", 4 + len(chunks)) + b"WAVE" + chunks
+
+
+def _swapped(samples):
+    copy = array.array("h", samples)
+    copy.byteswap()
+    return copy.tobytes()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Re-encode audio clips into WAV (IMA ADPCM or PCM)")
+    parser.add_argument("clips", nargs="+", help="clips to convert (e.g. data/*.mp3)")
+    parser.add_argument("--rate", type=int, default=22050, help="sample rate in Hz (default 22050)")
+    parser.add_argument("--bits", type=int, choices=(4, 8, 16), default=4,
+                        help="4 for IMA ADPCM, 8 or 16 for PCM (default 4)")
+    parser.add_argument("--stereo", action="store_true", help="keep two channels (default mono)")
+    parser.add_argument("--block-size", type=int, default=512, help="IMA ADPCM block size in bytes (default 512)")
+    parser.add_argument("--output", help="directory of the converted clips (default next to the originals)")
+    args = parser.parse_args()
+
+    channels = 2 if args.stereo else 1
+    if args.block_size <= 4 * channels or (args.block_size - 4 * channels) % (4 * channels):
+        parser.error("block size must be 4 * channels bytes of header plus a multiple of 4 * channels bytes")
+
+    total_original = total_converted = 0
+    print("%-30s %10s %10s %8s" % ("clip", "original", "wav", "seconds"))
+    for clip in args.clips:
+        samples = decode(clip, args.rate, channels)
+        converted = wav(samples, args.rate, channels, args.bits, args.block_size)
+        directory = args.output or os.path.dirname(clip)
+        target = os.path.join(directory, os.path.splitext(os.path.basename(clip))[0] + ".wav")
+        with open(target, "wb") as f:
+            f.write(converted)
+        original = os.path.getsize(clip)
+        total_original += original
+        total_converted += len(converted)
+        print("%-30s %10d %10d %8.1f" % (os.path.basename(clip), original, len(converted),
+                                        len(samples) / channels / args.rate))
+    print("%-30s %10d %10d" % ("total", total_original, total_converted))
+
+
+if __name__ == "__main__":
+    main()
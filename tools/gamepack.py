@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+Compiles the game configuration (data/config.json) into a binary game pack.
+
+The pack is flashed into the `gamepack` partition and the firmware reads it in place (memory mapped),
+without parsing the JSON configuration on every boot.
+
+Layout (little endian, all sections aligned to 4 bytes):
+
+    header          see HEADER below
+    settings        minified JSON of the settings sections (everything except waypoints)
+    latitudes       int32[waypoints], 1e-7 deg
+    longitudes      int32[waypoints], 1e-7 deg
+    ids             uint16[waypoints]
+    path indexes    uint16[waypoints], index into the path table
+    path offsets    uint16[paths], offset of the path in path data
+    path data       NUL terminated paths (audio clips used by the game)
+
+CRC32 (zlib) covers everything after the header.
+
+Usage:
+    python tools/gamepack.py data/config.json gamepack.bin
+    esptool.py --chip esp32 write_flash 0x3B0000 gamepack.bin
+"""
+
+import argparse
+import json
+import struct
+import sys
+import zlib
+
+MAGIC = b"GPAK"
+VERSION = 1
+# magic, version, header size, total size, crc, settings (offset, size), waypoints count,
+# latitudes, longitudes, ids, path indexes offsets, paths count, path offsets offset, path data (offset, size)
+HEADER = struct.Struct("<4sHHII II I IIII I I II")
+PARTITION_SIZE = 0x20000
+SETTINGS_SECTIONS = ("general", "mqtt", "gsm", "gps", "sleep", "report", "motion", "diagnostics", "audio")
+
+
+def align(buffer):
+    while len(buffer) % 4:
+        buffer.append(0)
+
+
+def build(config):
+    settings = {key: config[key] for key in SETTINGS_SECTIONS if key in config}
+    waypoints = config.get("waypoints", [])
+
+    paths = []
+    path_indexes = []
+    for w in waypoints:
+        path = w.get("path", "")
+        if path not in paths:
+            paths.append(path)
+        path_indexes.append(paths.index(path))
+
+    if len(waypoints) > 0xFFFF or len(paths) > 0xFFFF:
+        raise ValueError("too many waypoints or paths")
+    if any(int(w["id"]) > 0xFFFF for w in waypoints):
+        raise ValueError("waypoint id exceeds 16 bits")
+
+    body = bytearray()
+    offsets = {}
+
+    def section(name, data):
+        align(body)
+        offsets[name] = HEADER.size + len(body)
+        body.extend(data)
+
+    settings_json = json.dumps(settings, separators=(",", ":")).encode()
+    section("settings", settings_json)
+    section("lats", struct.pack("<%di" % len(waypoints), *(round(float(w["lat"]) * 1e7) for w in waypoints)))
+    section("lons", struct.pack("<%di" % len(waypoints), *(round(float(w["lon"]) * 1e7) for w in waypoints)))
+    section("ids", struct.pack("<%dH" % len(waypoints), *(int(w["id"]) for w in waypoints)))
+    section("path_indexes", struct.pack("<%dH" % len(waypoints), *path_indexes))
+
+    path_data = bytearray()
+    path_offsets = []
+    for path in paths:
+        path_offsets.append(len(path_data))
+        path_data.extend(path.encode() + b"\0")
+    if len(path_data) > 0xFFFF:
+        raise ValueError("paths are too long")
+    section("path_offsets", struct.pack("<%dH" % len(paths), *path_offsets))
+    section("path_data", path_data)
+    align(body)
+
+    header = HEADER.pack(MAGIC, VERSION, HEADER.size, HEADER.size + len(body), zlib.crc32(body),
+                         offsets["settings"], len(settings_json),
+                         len(waypoints), offsets["lats"], offsets["lons"], offsets["ids"], offsets["path_indexes"],
+                         len(paths), offsets["path_offsets"], offsets["path_data"], len(path_data))
+    return header + bytes(body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile config.json into a binary game pack")
+    parser.add_argument("config", help="path to config.json")
+    parser.add_argument("output", help="path of the resulting pack")
+    args = parser.parse_args()
+
+    with open(args.config) as f:
+        pack = build(json.load(f))
+    if len(pack) > PARTITION_SIZE:
+        sys.exit("pack has %d bytes, the partition has only %d" % (len(pack), PARTITION_SIZE))
+    with open(args.output, "wb") as f:
+        f.write(pack)
+    print("%s: %d bytes" % (args.output, len(pack)))
+
+
+if __name__ == "__main__":
+    main()
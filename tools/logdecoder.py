@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""
+Decodes binary log frames written by the firmware (see src/logger/LogRecord.h) into text.
+
+The firmware stores only the address of the format string, the string itself is read from the ELF file
+of the same build. Anything which is not a valid frame (boot messages, modem debug output) is passed through.
+
+Frame (little endian):
+
+    0xF5, version           sync
+    header                  length (uint16, whole record), level (uint8), flags (uint8),
+                            timestamp (uint32, ms), format address (uint32)
+    arguments               type (uint8) + value, type 0 ends the list
+    checksum                uint8, sum of the record bytes
+
+Usage:
+    python tools/logdecoder.py .pio/build/usb/firmware.elf --port /dev/ttyUSB0
+    python tools/logdecoder.py .pio/build/usb/firmware.elf captured.bin
+    nc tracker.local 23 | python tools/logdecoder.py .pio/build/usb/firmware.elf
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xF5
+VERSION = 1
+HEADER = struct.Struct("<HBBII")
+LEVELS = {0: "[DBG]", 1: "[INFO]", 2: "[WARN]", 3: "[ERR]"}
+
+FLAG_LITERAL = 0x01
+FLAG_NEWLINE = 0x02
+FLAG_INLINE_FORMAT = 0x04
+FLAG_DROPPED = 0x08
+
+DROP_REASONS = {0: "ring full", 1: "sink rate limit", 2: "sink buffer full"}
+
+ARGUMENTS = {
+    ord("i"): struct.Struct("<i"),
+    ord("u"): struct.Struct("<I"),
+    ord("q"): struct.Struct("<q"),
+    ord("Q"): struct.Struct("<Q"),
+    ord("d"): struct.Struct("<d"),
+    ord("p"): struct.Struct("<I"),
+}
+ARG_STRING = ord("s")
+
+SPECIFIER = re.compile(r"%([-+ #0]*)(\d+)?(?:\.(\d+))?(?:hh|h|ll|l|L|z|j|t)?([diouxXeEfFgGaAcspn%])")
+
+
+class Elf:
+    """Minimal reader of string constants from a 32-bit little endian ELF file."""
+
+    SHT_NOBITS = 8
+    SHF_ALLOC = 0x2
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("%s is not a 32-bit little endian ELF file" % path)
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from("<IIIIII", self.data, shoff + i * shentsize)
+            if sh_type != self.SHT_NOBITS and flags & self.SHF_ALLOC and size > 0:
+                self.sections.append((addr, offset, size))
+        self.cache = {}
+
+    def string(self, address):
+        if address not in self.cache:
+            self.cache[address] = self._read(address)
+        return self.cache[address]
+
+    def _read(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.find(b"\0", start, offset + size)
+                return self.data[start:end if end >= 0 else offset + size].decode("utf-8", "replace")
+        return None
+
+
+def parse_arguments(payload):
+    arguments = []
+    position = 0
+    while position < len(payload) and payload[position] != 0:
+        kind = payload[position]
+        position += 1
+        if kind == ARG_STRING:
+            length = payload[position]
+            arguments.append(payload[position + 1:position + 1 + length].decode("utf-8", "replace"))
+            position += 1 + length
+        elif kind in ARGUMENTS:
+            value, = ARGUMENTS[kind].unpack_from(payload, position)
+            arguments.append(value)
+            position += ARGUMENTS[kind].size
+        else:
+            raise ValueError("unknown argument type %d" % kind)
+    return arguments
+
+
+def format_argument(flags, width, precision, conversion, value):
+    spec = "%" + flags + (width or "") + ("." + precision if precision else "")
+    try:
+        if conversion in "diu":
+            return (spec + "d") % value
+        if conversion in "oxX":
+            return (spec + conversion) % (value & 0xFFFFFFFF if isinstance(value, int) and value < 0 else value)
+        if conversion in "eEfFgG":
+            return (spec + conversion) % float(value)
+        if conversion in "aA":
+            return float(value).hex()
+        if conversion == "c":
+            return chr(value) if isinstance(value, int) else str(value)
+        if conversion == "p":
+            return "0x%08x" % value
+        return (spec + "s") % (value,)
+    except (TypeError, ValueError):
+        return str(value)
+
+
+def format_message(form, arguments):
+    arguments = list(arguments)
+
+    def replace(match):
+        flags, width, precision, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        if conversion == "n" or not arguments:
+            return match.group(0) if not arguments else ""
+        return format_argument(flags, width, precision, conversion, arguments.pop(0))
+
+    return SPECIFIER.sub(replace, form)
+
+
+def decode_record(elf, record):
+    length, level, flags, timestamp, address = HEADER.unpack_from(record)
+    arguments = parse_arguments(record[HEADER.size:length])
+    if flags & FLAG_DROPPED:
+        message = "%d log records dropped (%s)\n" % (arguments[0], DROP_REASONS.get(arguments[1], "?"))
+    else:
+        if flags & FLAG_INLINE_FORMAT:
+            form = arguments.pop(0)
+        else:
+            form = elf.string(address)
+            if form is None:
+                form = "<unknown format 0x%08x, wrong ELF?> %s" % (address, " ".join(map(str, arguments)))
+                arguments = []
+        message = form if flags & FLAG_LITERAL else format_message(form, arguments)
+        if flags & FLAG_NEWLINE:
+            message += "\n"
+    return "%10.3f %s %s" % (timestamp / 1000, LEVELS.get(level, "[???]"), message)
+
+
+class Decoder:
+    """Splits the stream into frames and text, keeps incomplete frames for the next chunk."""
+
+    def __init__(self, elf, out):
+        self.elf = elf
+        self.out = out
+        self.pending = bytearray()
+
+    def feed(self, chunk):
+        self.pending += chunk
+        while self.pending:
+            sync = self.pending.find(FRAME_SYNC)
+            if sync < 0:
+                self._text(self.pending)
+                self.pending.clear()
+                return
+            if sync > 0:
+                self._text(self.pending[:sync])
+                del self.pending[:sync]
+            if len(self.pending) < 2 + HEADER.size:
+                return
+            length, = struct.unpack_from("<H", self.pending, 2)
+            if self.pending[1] != VERSION or length < HEADER.size or length % 4:
+                self._text(self.pending[:1])
+                del self.pending[:1]
+                continue
+            if len(self.pending) < 2 + length + 1:
+                return
+            record = bytes(self.pending[2:2 + length])
+            if sum(record) & 0xFF != self.pending[2 + length]:
+                self._text(self.pending[:1])
+                del self.pending[:1]
+                continue
+            try:
+                self.out.write(decode_record(self.elf, record))
+            except (ValueError, IndexError, struct.error) as e:
+                self.out.write("<corrupted record: %s>\n" % e)
+            del self.pending[:2 + length + 1]
+        self.out.flush()
+
+    def _text(self, data):
+        self.out.write(bytes(data).decode("utf-8", "replace"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes binary logs of the tracker.")
+    parser.add_argument("elf", help="firmware.elf of the running build")
+    parser.add_argument("input", nargs="?", default="-", help="captured log file, stdin by default")
+    parser.add_argument("--port", help="read from a serial port instead (requires pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    decoder = Decoder(Elf(args.elf), sys.stdout)
+    if args.port:
+        import serial
+        source = serial.Serial(args.port, args.baud, timeout=0.1)
+    elif args.input == "-":
+        source = sys.stdin.buffer
+    else:
+        source = open(args.input, "rb")
+
+    try:
+        while True:
+            chunk = source.read(256) if args.port else source.read1(4096)
+            if not chunk:
+                if args.port:
+                    continue
+                break
+            decoder.feed(chunk)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        source.close()
+
+
+if __name__ == "__main__":
+    main()